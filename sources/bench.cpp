@@ -0,0 +1,304 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	// stages too quick for the clock report no rate rather than inf or nan
+	static double rate(size_t n, double seconds) {
+		return seconds > 0.0 ? n / seconds : 0.0;
+	}
+
+	bench::bench(const sptr_t<render::fonts>& fonts, int iterations) :
+		_fonts(fonts),
+		_iterations(std::max(iterations, 1)),
+		_scratch(fs::temp_directory_path() / "obml-bench") {
+
+		fs::create_directories(_scratch);
+	}
+
+	bench::~bench() {
+		std::error_code ec;
+		fs::remove_all(_scratch, ec);
+	}
+
+	void bench::run_reader() {
+		struct primitive {
+			const char* name;
+			size_t size;
+			std::function<int64_t(reader&)> read;
+		};
+
+		static const size_t count = 1 << 20;
+		static const int16_t string_len = 16;
+
+		const primitive primitives[] = {
+			{ "reader::read_short", 2, [](reader& r) { return r.read_short(); } },
+			{ "reader::read_medium", 3, [](reader& r) { return r.read_medium(); } },
+			{ "reader::read_coord", 5, [](reader& r) { return static_cast<int64_t>(r.read_coord().y); } },
+			{ "reader::read_color", 4, [](reader& r) { return r.read_color().toInteger(); } },
+			{ "reader::read_string", 2 + string_len, [](reader& r) { return r.read_string().size(); } },
+		};
+
+		for (const auto& i : primitives) {
+			path file = _scratch / "reader.bin";
+
+			{
+				std::ofstream out(file, std::ios::out | std::ios::trunc | std::ios::binary);
+				blob record(i.size);
+
+				std::mt19937 rng(0x0b31);
+				for (size_t j = 0; j < count; j++) {
+					for (auto& k : record)
+						k = static_cast<char>(rng());
+
+					// strings need a valid length prefix
+					if (i.size == 2 + string_len) {
+						record[0] = 0;
+						record[1] = string_len;
+					}
+
+					out.write(record.data(), record.size());
+				}
+			}
+
+			volatile int64_t sink = 0;
+			sf::Clock clock;
+
+			for (int j = 0; j < _iterations; j++) {
+				reader r(file);
+				for (size_t k = 0; k < count; k++)
+					sink = sink + i.read(r);
+			}
+
+			add(i.name, "", clock.getElapsedTime().asSeconds() / _iterations, count * i.size, count);
+		}
+	}
+
+	void bench::run_page(const path& file) {
+		std::string name = file.u8string();
+		size_t bytes = static_cast<size_t>(fs::file_size(file));
+
+		std::cout << "Benchmarking '" << name << "'..." << std::endl;
+
+		// parse: the page profiler already times each section
+		std::map<std::string, double> stages;
+		size_t links = 0, tiles = 0, images = 0;
+
+		for (int i = 0; i < _iterations; i++) {
+			sf::Clock clock;
+			page p(file);
+			stages["parse"] += clock.getElapsedTime().asSeconds();
+
+			if (p.get_err() != parser::err::none) {
+				std::cout << "WARNING: '" << name << "' failed to parse (" << p.get_err() << ")" << std::endl;
+				return;
+			}
+
+			for (const auto& j : p.get_profiler().get_stages())
+				stages[j.name] += j.last() / 1000.0;
+
+			links = p.get_links().size();
+			tiles = p.get_tiles().size();
+			images = p.get_images().size();
+		}
+
+		add("parser::parse", name, stages["parse"] / _iterations, bytes, links + tiles + images);
+		add("reader::load", name, stages["read"] / _iterations, bytes, 1);
+		add("parser::read_header", name, stages["header"] / _iterations, 0, 1);
+		add("parser::read_metadata", name, stages["metadata"] / _iterations, 0, 0);
+		add("parser::read_links", name, stages["links"] / _iterations, 0, links);
+		add("parser::read_content", name, stages["content"] / _iterations, 0, tiles);
+		add("parser::decode_images", name, stages["images"] / _iterations, 0, images);
+
+		page p(file);
+		p.set_fonts(_fonts);
+
+		{
+			// a second copy of the page finds its images decoded by the first
+			image_cache::stats before = image_cache::shared().get_stats();
+
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++)
+				page copy(file);
+
+			add("parser::parse(cached images)", name, clock.getElapsedTime().asSeconds() / _iterations, bytes, links + tiles + images);
+
+			image_cache::stats after = image_cache::shared().get_stats();
+
+			std::unordered_set<const sf::Texture*> distinct;
+			for (const auto& i : p.get_images())
+				distinct.insert(i.texture.get());
+
+			std::cout << "  " << name << ": " << images << " images, " << distinct.size() << " distinct, "
+				<< after.hits - before.hits << " of " << after.lookups - before.lookups << " cache lookups hit" << std::endl;
+		}
+
+		{
+			// the same records without building the lists or decoding images
+			scanner _scanner(p.get_source());
+			stats _stats;
+
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++)
+				_scanner.scan(_stats);
+
+			add("scanner::scan", name, clock.getElapsedTime().asSeconds() / _iterations, bytes, links + tiles + images);
+		}
+
+		{
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++)
+				p.prepare();
+
+			add("page::prepare", name, clock.getElapsedTime().asSeconds() / _iterations, 0, tiles);
+
+			// part of prepare, timed by the page itself
+			const geometry::cull_stats& cull = p.get_cull_stats();
+			for (const auto& j : p.get_profiler().get_stages())
+				if (j.name == "cull")
+					add("geometry::cull_tiles", name, j.average() / 1000.0, 0, cull.tiles);
+
+			std::cout << "  " << name << ": " << cull.covered << " of " << cull.tiles << " tiles covered, " << cull.blank << " blank" << std::endl;
+		}
+
+		{
+			obml_renderer::tiles merged;
+			geometry::merge_stats merge;
+
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++)
+				merge = geometry::merge_tiles(p.get_tiles(), merged);
+
+			add("geometry::merge_tiles", name, clock.getElapsedTime().asSeconds() / _iterations, 0, merge.before);
+
+			std::cout << "  " << name << ": " << merge.before << " B tiles merged into " << merge.after << std::endl;
+		}
+
+		{
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++)
+				p.render();
+
+			add("page::render", name, clock.getElapsedTime().asSeconds() / _iterations, 0, tiles, 1);
+		}
+
+		{
+			sf::RenderTexture rt;
+			rt.create(1280, 720);
+
+			sf::Clock clock;
+			for (int i = 0; i < _iterations; i++) {
+				p.render(rt);
+				rt.display();
+			}
+
+			add("page::render(target)", name, clock.getElapsedTime().asSeconds() / _iterations, 0, tiles, 1);
+
+			// zoomed out: spans fill in over the first frames, then are drawn as they are
+			rt.setView(sf::View({ 0.f, 0.f, 1280.f * 16.f, 720.f * 16.f }));
+
+			clock.restart();
+			for (int i = 0; i < _iterations; i++) {
+				p.render(rt);
+				rt.display();
+			}
+
+			add("page::render(zoomed out)", name, clock.getElapsedTime().asSeconds() / _iterations, 0, tiles, 1);
+		}
+
+		std::string dest = (_scratch / "").string();
+
+		rect region{ { 0, 0 }, {
+			std::min(256, p.get_header().size.x),
+			std::min(256, p.get_header().size.y)
+		} };
+		if (!p.get_links().empty() && !p.get_links().front().regions.empty())
+			region = p.get_links().front().regions.front();
+
+		const std::pair<const char*, std::function<void()>> exports[] = {
+			{ "page::export_page(png)", [&] { p.export_page(dest, "png"); } },
+			{ "page::export_page(jpeg)", [&] { p.export_page(dest, "jpeg"); } },
+			{ "page::export_region", [&] { p.export_region(dest, region); } },
+			{ "page::export_images", [&] { p.export_images(dest); } },
+		};
+
+		for (const auto& i : exports) {
+			sf::Clock clock;
+			for (int j = 0; j < _iterations; j++)
+				i.second();
+
+			add(i.first, name, clock.getElapsedTime().asSeconds() / _iterations, 0, 0, 1);
+		}
+	}
+
+	void bench::run_synthetic(const std::vector<size_t>& sizes) {
+		for (auto i : sizes) {
+			std::stringstream name;
+			name << "synthetic_" << i << ".obml";
+
+			path file = _scratch / name.str();
+			generator _generator(generator::for_size(std::min(i, generator::max_size), generator::options()));
+
+			if (_generator.generate(file))
+				run_page(file);
+		}
+	}
+
+	void bench::print(std::ostream& out) const {
+		out << std::endl;
+
+		for (const auto& i : _results) {
+			out
+				<< std::left << std::setw(28) << i.name
+				<< std::right << std::fixed << std::setprecision(3)
+				<< std::setw(12) << i.seconds * 1000.0 << " ms"
+			;
+
+			if (i.bytes > 0)
+				out << std::setw(12) << rate(i.bytes, i.seconds) / (1024.0 * 1024.0) << " MB/s";
+
+			if (i.records > 0)
+				out << std::setw(14) << rate(i.records, i.seconds) << " rec/s";
+
+			if (i.frames > 0)
+				out << std::setw(12) << rate(i.frames, i.seconds) << " fps";
+
+			if (!i.file.empty())
+				out << "  " << path(i.file).filename().u8string();
+
+			out << std::defaultfloat << std::endl;
+		}
+
+		out << std::endl;
+	}
+
+	void bench::write_json(std::ostream& out) const {
+		out << "{\"results\":[";
+
+		for (size_t i = 0; i < _results.size(); i++) {
+			const result& r = _results[i];
+
+			out
+				<< (i > 0 ? "," : "") << "\n"
+				<< "{\"name\":\"" << json::escape(r.name) << "\""
+				<< ",\"file\":\"" << json::escape(r.file) << "\""
+				<< ",\"iterations\":" << r.iterations
+				<< ",\"seconds\":" << r.seconds
+				<< ",\"bytes\":" << r.bytes
+				<< ",\"records\":" << r.records
+				<< ",\"mb_per_s\":" << rate(r.bytes, r.seconds) / (1024.0 * 1024.0)
+				<< ",\"records_per_s\":" << rate(r.records, r.seconds)
+				<< ",\"frames_per_s\":" << rate(r.frames, r.seconds)
+				<< "}"
+			;
+		}
+
+		out << "\n]}" << std::endl;
+	}
+
+	const std::vector<bench::result>& bench::get_results() const {
+		return _results;
+	}
+
+	void bench::add(const std::string& name, const std::string& file, double seconds, size_t bytes, size_t records, size_t frames) {
+		_results.push_back({ name, file, static_cast<size_t>(_iterations), seconds, bytes, records, frames });
+	}
+};
\ No newline at end of file
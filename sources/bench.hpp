@@ -0,0 +1,46 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	class bench : private sf::NonCopyable {
+	public:
+		struct result {
+			std::string name;
+			std::string file;
+
+			size_t iterations;
+			double seconds;		// per iteration
+
+			size_t bytes;		// per iteration
+			size_t records;		// per iteration
+			size_t frames;		// per iteration
+		};
+
+		bench(const sptr_t<render::fonts>& fonts, int iterations);
+		~bench();
+
+		// primitive decoding over a synthetic scratch file
+		void run_reader();
+
+		// parser sections, prepare, render and exports of one page
+		void run_page(const path& file);
+
+		// generated pages of increasing size, see generator
+		void run_synthetic(const std::vector<size_t>& sizes);
+
+		void print(std::ostream& out) const;
+		void write_json(std::ostream& out) const;
+
+		const std::vector<result>& get_results() const;
+
+	private:
+		sptr_t<render::fonts> _fonts;
+		std::vector<result> _results;
+
+		int _iterations;
+		path _scratch;
+
+		void add(const std::string& name, const std::string& file, double seconds, size_t bytes, size_t records, size_t frames = 0);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	namespace cache {
+		static const char atlas_magic[8] = { 'O', 'B', 'M', 'L', 'A', 'T', 'L', '1' };
+		static const char charsets_magic[8] = { 'O', 'B', 'M', 'L', 'G', 'L', 'Y', '1' };
+
+		template<typename T> static void write(std::ostream& out, const T& value) {
+			out.write(reinterpret_cast<const char*>(&value), sizeof value);
+		}
+
+		template<typename T> static bool read(std::istream& in, T& value) {
+			return in.read(reinterpret_cast<char*>(&value), sizeof value).good();
+		}
+
+		static bool read_magic(std::istream& in, const char (&magic)[8], uint64_t key) {
+			char buf[8];
+			uint64_t stored = 0;
+
+			if (!in.read(buf, sizeof buf).good() || memcmp(buf, magic, sizeof buf) != 0)
+				return false;
+
+			return read(in, stored) && stored == key;
+		}
+
+		uint64_t hash(const char* data, size_t len, uint64_t seed) {
+			// FNV-1a over 8-byte words, tail byte-wise
+			const uint64_t prime = 0x100000001b3ULL;
+			uint64_t h = seed;
+
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+				uint64_t w;
+				memcpy(&w, data + i, sizeof w);
+				h = (h ^ w) * prime;
+			}
+
+			for (; i < len; i++)
+				h = (h ^ static_cast<uint8_t>(data[i])) * prime;
+
+			return h;
+		}
+
+		uint64_t hash_file(const path& _path) {
+			std::ifstream in(_path, std::ios::in | std::ios::binary);
+			if (!in.is_open())
+				return 0;
+
+			blob buf(1 << 16);
+			uint64_t h = 0xcbf29ce484222325ULL;
+
+			while (in) {
+				in.read(buf.data(), buf.size());
+				h = hash(buf.data(), static_cast<size_t>(in.gcount()), h);
+			}
+
+			return h;
+		}
+
+		path get_path(const char* prefix, uint64_t key, const char* ext) {
+			std::stringstream ss;
+			ss << prefix << "_" << std::hex << std::setw(16) << std::setfill('0') << key << "." << ext;
+
+			return path(directory) / ss.str();
+		}
+
+		bool load_atlas(const path& _path, uint64_t key, ImFontAtlas& atlas) {
+			std::ifstream in(_path, std::ios::in | std::ios::binary);
+			if (!in.is_open() || !read_magic(in, atlas_magic, key))
+				return false;
+
+			int width = 0, height = 0;
+			if (!read(in, width) || !read(in, height) || width <= 0 || height <= 0)
+				return false;
+
+			atlas.Clear();
+
+			atlas.TexWidth = width;
+			atlas.TexHeight = height;
+			atlas.TexPixelsAlpha8 = static_cast<unsigned char*>(IM_ALLOC(width * height));
+			in.read(reinterpret_cast<char*>(atlas.TexPixelsAlpha8), width * height);
+
+			read(in, atlas.TexUvScale);
+			read(in, atlas.TexUvWhitePixel);
+			read(in, atlas.TexUvLines);
+			read(in, atlas.PackIdMouseCursors);
+			read(in, atlas.PackIdLines);
+
+			int rects = 0, fonts = 0;
+
+			read(in, rects);
+			atlas.CustomRects.resize(rects);
+			for (auto& i : atlas.CustomRects) {
+				int font = -1;
+
+				read(in, i.Width); read(in, i.Height);
+				read(in, i.X); read(in, i.Y);
+				read(in, i.GlyphID);
+				read(in, i.GlyphAdvanceX);
+				read(in, i.GlyphOffset);
+				read(in, font);
+
+				i.Font = nullptr;
+				if (font >= 0)
+					i.Font = reinterpret_cast<ImFont*>(static_cast<intptr_t>(font + 1)); // resolved below
+			}
+
+			read(in, fonts);
+			for (int i = 0; i < fonts && in.good(); i++) {
+				ImFont* font = IM_NEW(ImFont)();
+				int glyphs = 0;
+
+				font->ContainerAtlas = &atlas;
+
+				read(in, font->FontSize);
+				read(in, font->Scale);
+				read(in, font->Ascent);
+				read(in, font->Descent);
+				read(in, font->FallbackChar);
+				read(in, font->EllipsisChar);
+				read(in, font->MetricsTotalSurface);
+
+				read(in, glyphs);
+				font->Glyphs.resize(glyphs);
+				in.read(reinterpret_cast<char*>(font->Glyphs.Data), sizeof(ImFontGlyph) * glyphs);
+
+				font->BuildLookupTable();
+				atlas.Fonts.push_back(font);
+			}
+
+			for (auto& i : atlas.CustomRects) if (i.Font != nullptr) {
+				int font = static_cast<int>(reinterpret_cast<intptr_t>(i.Font)) - 1;
+				i.Font = font < atlas.Fonts.Size ? atlas.Fonts[font] : nullptr;
+			}
+
+			if (!in.good() || atlas.Fonts.empty()) {
+				atlas.Clear();
+				return false;
+			}
+
+			return true;
+		}
+
+		bool save_atlas(const path& _path, uint64_t key, ImFontAtlas& atlas) {
+			unsigned char* pixels = nullptr;
+			int width = 0, height = 0;
+
+			atlas.GetTexDataAsAlpha8(&pixels, &width, &height);
+			if (pixels == nullptr)
+				return false;
+
+			std::error_code ec;
+			fs::create_directories(_path.parent_path(), ec);
+
+			std::ofstream out(_path, std::ios::out | std::ios::trunc | std::ios::binary);
+			if (!out.is_open())
+				return false;
+
+			out.write(atlas_magic, sizeof atlas_magic);
+			write(out, key);
+
+			write(out, width);
+			write(out, height);
+			out.write(reinterpret_cast<const char*>(pixels), width * height);
+
+			write(out, atlas.TexUvScale);
+			write(out, atlas.TexUvWhitePixel);
+			write(out, atlas.TexUvLines);
+			write(out, atlas.PackIdMouseCursors);
+			write(out, atlas.PackIdLines);
+
+			write(out, atlas.CustomRects.Size);
+			for (const auto& i : atlas.CustomRects) {
+				write(out, i.Width); write(out, i.Height);
+				write(out, i.X); write(out, i.Y);
+				write(out, i.GlyphID);
+				write(out, i.GlyphAdvanceX);
+				write(out, i.GlyphOffset);
+				write(out, i.Font != nullptr ? atlas.Fonts.index_from_ptr(atlas.Fonts.find(i.Font)) : -1);
+			}
+
+			write(out, atlas.Fonts.Size);
+			for (const ImFont* i : atlas.Fonts) {
+				write(out, i->FontSize);
+				write(out, i->Scale);
+				write(out, i->Ascent);
+				write(out, i->Descent);
+				write(out, i->FallbackChar);
+				write(out, i->EllipsisChar);
+				write(out, i->MetricsTotalSurface);
+
+				write(out, i->Glyphs.Size);
+				out.write(reinterpret_cast<const char*>(i->Glyphs.Data), sizeof(ImFontGlyph) * i->Glyphs.Size);
+			}
+
+			return out.good();
+		}
+
+		bool load_charsets(const path& _path, uint64_t key, charsets& sets) {
+			std::ifstream in(_path, std::ios::in | std::ios::binary);
+			if (!in.is_open() || !read_magic(in, charsets_magic, key))
+				return false;
+
+			int8_t font = 0;
+			uint32_t count = 0;
+
+			while (read(in, font) && read(in, count)) {
+				std::vector<sf::Uint32> points(count);
+				if (!in.read(reinterpret_cast<char*>(points.data()), count * sizeof(sf::Uint32)).good())
+					return false;
+
+				sets[font].insert(points.begin(), points.end());
+			}
+
+			return true;
+		}
+
+		bool save_charsets(const path& _path, uint64_t key, const charsets& sets) {
+			std::error_code ec;
+			fs::create_directories(_path.parent_path(), ec);
+
+			std::ofstream out(_path, std::ios::out | std::ios::trunc | std::ios::binary);
+			if (!out.is_open())
+				return false;
+
+			out.write(charsets_magic, sizeof charsets_magic);
+			write(out, key);
+
+			for (const auto& i : sets) {
+				std::vector<sf::Uint32> points(i.second.begin(), i.second.end());
+
+				write(out, i.first);
+				write(out, static_cast<uint32_t>(points.size()));
+				out.write(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(sf::Uint32));
+			}
+
+			return out.good();
+		}
+	};
+};
\ No newline at end of file
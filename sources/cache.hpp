@@ -0,0 +1,23 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// on-disk cache of rasterized font data, keyed by font file hash
+	namespace cache {
+		static const char* directory = "cache";
+
+		uint64_t hash(const char* data, size_t len, uint64_t seed = 0xcbf29ce484222325ULL);
+		uint64_t hash_file(const path& _path);
+
+		path get_path(const char* prefix, uint64_t key, const char* ext);
+
+		// ImGui font atlas: alpha8 pixels, custom rects and per-font glyph tables
+		bool load_atlas(const path& _path, uint64_t key, ImFontAtlas& atlas);
+		bool save_atlas(const path& _path, uint64_t key, ImFontAtlas& atlas);
+
+		// code points seen per font id, used to pre-warm sf::Font glyph pages
+		bool load_charsets(const path& _path, uint64_t key, charsets& sets);
+		bool save_charsets(const path& _path, uint64_t key, const charsets& sets);
+	};
+};
\ No newline at end of file
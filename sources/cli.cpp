@@ -0,0 +1,550 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	// the whole string has to be a decimal number that fits T
+	template <typename T>
+	static bool parse_number(const std::string& s, T& value) {
+		if (s.empty() || !(std::isdigit(static_cast<unsigned char>(s[0])) || s[0] == '-' || s[0] == '.'))
+			return false;
+
+		char* end = nullptr;
+		errno = 0;
+
+		if constexpr (std::is_floating_point_v<T>) {
+			double v = std::strtod(s.c_str(), &end);
+			if (errno != 0 || *end != '\0' || !std::isfinite(v))
+				return false;
+
+			value = static_cast<T>(v);
+		}
+		else if constexpr (std::is_signed_v<T>) {
+			long long v = std::strtoll(s.c_str(), &end, 10);
+			if (errno != 0 || *end != '\0' || v < std::numeric_limits<T>::min() || v > std::numeric_limits<T>::max())
+				return false;
+
+			value = static_cast<T>(v);
+		}
+		else {
+			unsigned long long v = std::strtoull(s.c_str(), &end, 10);
+			if (s[0] == '-' || errno != 0 || *end != '\0' || v > std::numeric_limits<T>::max())
+				return false;
+
+			value = static_cast<T>(v);
+		}
+
+		return true;
+	}
+
+	cli::cli(int argc, char* argv[]) {
+		for (int i = 1; i < argc; i++) {
+			std::string arg = argv[i];
+
+			if (_command.empty() && arg.size() > 2 && arg.compare(0, 2, "--") == 0)
+				_command = arg.substr(2);
+
+			else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0) {
+				auto eq = arg.find('=');
+
+				if (eq != std::string::npos)
+					_options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+				else
+					_options[arg.substr(2)] = "";
+			}
+			else
+				_args.push_back(arg);
+		}
+	}
+
+	bool cli::has_command() const {
+		return !_command.empty();
+	}
+
+	int cli::run() {
+		if (has_option("trace"))
+			trace::start(get_option("trace", "trace.json"));
+
+		int ret = 1;
+
+		if (_command == "bench")
+			ret = run_bench();
+		else if (_command == "generate")
+			ret = run_generate();
+		else if (_command == "serve")
+			ret = run_serve();
+		else if (_command == "stats")
+			ret = run_stats();
+		else if (_command == "dump")
+			ret = run_dump();
+		else if (_command == "links")
+			ret = run_links();
+		else if (_command == "text")
+			ret = run_text();
+		else if (_command == "index")
+			ret = run_index();
+		else if (_command == "query")
+			ret = run_query();
+		else if (_command == "probe")
+			ret = run_probe();
+		else
+			ret = usage();
+
+		trace::stop();
+
+		return ret;
+	}
+
+	int cli::usage() {
+		std::cout
+			<< "usage: obml-renderer [--<command> [options] [files or directories...]]" << std::endl
+			<< std::endl
+			<< "commands:" << std::endl
+			<< "  --bench [--iterations=N] [--out=results.json] <corpus...>" << std::endl
+			<< "  --bench ... --synthetic" << std::endl
+			<< "      benchmark reader, parser, prepare, render and exports" << std::endl
+			<< "      (--synthetic adds generated pages from 1KB to the 8MB format limit)" << std::endl
+			<< "  --generate --out=page.obml [--bytes=N | --tiles=N] [--width=W] [--height=H]" << std::endl
+			<< "             [--texts=F] [--links=F] [--images=N] [--image-size=WxH] [--seed=N]" << std::endl
+			<< "      write a synthetic OBML v6 page (densities are per B tile)" << std::endl
+			<< "  --serve [--workers=N] [--cache=N]" << std::endl
+			<< "      render daemon on stdin/stdout, one tab-separated job per line:" << std::endl
+			<< "      <id> <render|export|links|text|stats|quit> <file.obml|@bytes> [<dest> [<format>]]" << std::endl
+			<< "  --stats <corpus...>" << std::endl
+			<< "      count records over pages without building them" << std::endl
+			<< "  --dump [--records=links|text|all] <corpus...>" << std::endl
+			<< "      print one tab-separated line per record" << std::endl
+			<< "  --links [--workers=N] <corpus...>" << std::endl
+			<< "      JSON line per link (type, resolved href, regions), reading only up to the links section" << std::endl
+			<< "  --text [--lines] [--out=dir] [--workers=N] <corpus...>" << std::endl
+			<< "      UTF-8 text of every page in reading order (--lines joins runs into lines," << std::endl
+			<< "      --out writes one <page>.txt per page instead of stdout, under the same" << std::endl
+			<< "      subdirectories as in the corpus)" << std::endl
+			<< "  --index --out=dir [--batch=N] [--workers=N] <corpus...>" << std::endl
+			<< "      add the pages' text, titles and link hrefs to an on-disk inverted index" << std::endl
+			<< "  --query --index=dir [--limit=N] <words...>" << std::endl
+			<< "      JSON line per page containing every word, with the bounds of each match" << std::endl
+			<< "  --probe [--out=catalogue.jsonl] [--workers=N] <corpus...>" << std::endl
+			<< "      JSON line per page with its header only (version, size, title, urls, length)" << std::endl
+			<< std::endl
+			<< "options:" << std::endl
+			<< "  --trace=<file.json>   write Chrome trace events for the run" << std::endl
+		;
+
+		return _command == "help" ? 0 : 1;
+	}
+
+	int cli::run_bench() {
+		auto fonts = std::make_shared<render::fonts>();
+		if (!fonts->font.loadFromFile(render::default_font)) {
+			std::cout << "ERROR: can't load font '" << render::default_font << "'" << std::endl;
+			return 1;
+		}
+
+		int iterations = 5;
+		if (!get_number("iterations", iterations))
+			return usage();
+
+		bench _bench(fonts, iterations);
+
+		_bench.run_reader();
+
+		for (const auto& i : collect(_args))
+			_bench.run_page(i);
+
+		if (has_option("synthetic"))
+			_bench.run_synthetic({ 1 << 10, 16 << 10, 256 << 10, 1 << 20, 4 << 20, generator::max_size });
+
+		_bench.print(std::cout);
+
+		if (has_option("out")) {
+			std::ofstream out(get_option("out"), std::ios::out | std::ios::trunc);
+			_bench.write_json(out);
+		}
+		else
+			_bench.write_json(std::cout);
+
+		return 0;
+	}
+
+	int cli::run_generate() {
+		if (!has_option("out"))
+			return usage();
+
+		generator::options opts;
+
+		if (!get_number("width", opts.size.x)
+			|| !get_number("height", opts.size.y)
+			|| !get_number("texts", opts.text_density)
+			|| !get_number("links", opts.link_density)
+			|| !get_number("images", opts.images)
+			|| !get_number("seed", opts.seed)
+			|| !get_number("tiles", opts.tiles))
+			return usage();
+
+		std::string image_size = get_option("image-size", "32x32");
+		auto x = image_size.find('x');
+		if (x == std::string::npos
+			|| !parse_number(image_size.substr(0, x), opts.image_size.x)
+			|| !parse_number(image_size.substr(x + 1), opts.image_size.y)) {
+			std::cerr << "ERROR: --image-size expects WxH, not '" << image_size << "'" << std::endl;
+			return usage();
+		}
+
+		if (has_option("bytes")) {
+			size_t bytes = 0;
+			if (!get_number("bytes", bytes))
+				return usage();
+
+			opts = generator::for_size(bytes, opts);
+		}
+
+		generator _generator(opts);
+		if (!_generator.generate(get_option("out")))
+			return 1;
+
+		std::cout << "Generated '" << get_option("out") << "': " << _generator.get_data().size() << " bytes, " << opts.tiles << " tiles" << std::endl;
+		return 0;
+	}
+
+	int cli::run_serve() {
+		auto fonts = std::make_shared<render::fonts>();
+		if (!fonts->font.loadFromFile(render::default_font)) {
+			std::cerr << "ERROR: can't load font '" << render::default_font << "'" << std::endl;
+			return 1;
+		}
+
+		size_t workers = 0, cache_size = 16;
+		if (!get_number("workers", workers) || !get_number("cache", cache_size))
+			return usage();
+
+		// stdout carries the responses only, any other logging goes to stderr
+		std::ostream out(std::cout.rdbuf());
+		auto _cout = std::cout.rdbuf(std::cerr.rdbuf());
+
+		service _service(fonts, workers, cache_size);
+		int ret = _service.run(std::cin, out);
+
+		std::cout.rdbuf(_cout);
+		return ret;
+	}
+
+	int cli::run_stats() {
+		stats _stats;
+		sf::Clock clock;
+
+		for (const auto& i : collect(_args)) {
+			scanner _scanner(reader::load(i));
+
+			auto _err = _scanner.scan(_stats);
+			if (_err != scanner::err::none)
+				std::cerr << "WARNING: '" << i.u8string() << "' failed to scan (" << _err << ")" << std::endl;
+		}
+
+		_stats.print(std::cout, clock.getElapsedTime().asSeconds());
+		return 0;
+	}
+
+	int cli::run_dump() {
+		int sections = dumper::parse_records(get_option("records", "all"));
+		if (sections == 0)
+			return usage();
+
+		dumper _dumper(std::cout, sections);
+		auto files = collect(_args);
+
+		for (const auto& i : files) {
+			if (files.size() > 1)
+				std::cout << "# " << i.u8string() << "\n";
+
+			scanner _scanner(reader::load(i));
+
+			auto _err = _scanner.scan(_dumper, sections);
+			if (_err != scanner::err::none)
+				std::cerr << "WARNING: '" << i.u8string() << "' failed to scan (" << _err << ")" << std::endl;
+		}
+
+		std::cout.flush();
+		return 0;
+	}
+
+	int cli::run_links() {
+		return scan_pages(collect(_args), "links", std::cout, [](const path& file) {
+			std::stringstream out;
+			link_writer _writer(out, file.u8string());
+
+			scanner _scanner(scanner::load(file, scanner::section::links));
+			auto _err = _scanner.scan(_writer, scanner::section::links);
+
+			return page_output{ out.str(), _writer.get_count(), _err };
+		});
+	}
+
+	int cli::run_text() {
+		bool lines = has_option("lines");
+		path dest = get_option("out");
+
+		auto files = collect(_args);
+		std::map<path, path> names;
+
+		if (!dest.empty())
+			names = output_names(files, dest, ".txt");
+
+		return scan_pages(files, "texts", std::cout, [&](const path& file) {
+			text_writer _writer(lines);
+
+			// content only: the links and images are never decoded
+			scanner _scanner(scanner::load(file, scanner::section::content));
+			auto _err = _scanner.scan(_writer, scanner::section::content);
+
+			std::stringstream out;
+			std::string failed;
+
+			if (_err == scanner::err::none) {
+				if (dest.empty())
+					_writer.write(out);
+				else {
+					const path& name = names.at(file);
+
+					std::ofstream _out(name, std::ios::out | std::ios::trunc | std::ios::binary);
+					if (_out.is_open())
+						_writer.write(_out);
+
+					if (!_out.is_open() || !_out.flush())
+						failed = "can't write '" + name.u8string() + "'";
+				}
+			}
+
+			return page_output{ out.str(), _writer.get_count(), _err, failed };
+		});
+	}
+
+	int cli::run_index() {
+		if (!has_option("out"))
+			return usage();
+
+		size_t workers = 0, batch = 10000;
+		if (!get_number("workers", workers) || !get_number("batch", batch))
+			return usage();
+
+		auto files = collect(_args);
+		sf::Clock clock;
+
+		if (!corpus_index::build(files, get_option("out"), workers, batch))
+			return 1;
+
+		double seconds = clock.getElapsedTime().asSeconds();
+		std::cerr << files.size() << " pages indexed in " << seconds << "s ("
+			<< (seconds > 0 ? files.size() / seconds : 0) << " pages/s)" << std::endl;
+
+		return 0;
+	}
+
+	int cli::run_query() {
+		size_t limit = 100;
+		if (!has_option("index") || !get_number("limit", limit))
+			return usage();
+
+		// the query goes through the same word splitting as the indexed text
+		std::vector<std::string> terms;
+		for (const auto& i : _args)
+			tokenizer::split(i, [&](std::string_view word, size_t, size_t) { terms.emplace_back(word); });
+
+		sf::Clock clock;
+
+		corpus_index _index(get_option("index"));
+		auto results = _index.query(terms, limit);
+
+		for (const auto& r : results) {
+			std::cout << "{\"file\":\"" << json::escape(r.file) << "\",\"matches\":[";
+
+			bool first = true;
+			for (const auto& m : r.matches) {
+				std::cout << (first ? "" : ",")
+					<< "{\"term\":\"" << json::escape(terms[m.term]) << "\""
+					<< ",\"field\":\"" << corpus_index::field_name(m.where.field) << "\""
+					<< ",\"bounds\":[" << m.where.left << "," << m.where.top << "," << m.where.width << "," << m.where.height << "]}";
+				first = false;
+			}
+
+			std::cout << "]}\n";
+		}
+
+		std::cout.flush();
+		std::cerr << results.size() << " pages of " << _index.get_pages() << " in " << _index.get_segments() << " segments, "
+			<< clock.getElapsedTime().asMicroseconds() / 1000.0 << " ms" << std::endl;
+
+		return 0;
+	}
+
+	int cli::run_probe() {
+		std::ofstream file;
+		if (has_option("out")) {
+			file.open(get_option("out"), std::ios::out | std::ios::trunc | std::ios::binary);
+
+			if (!file.is_open()) {
+				std::cerr << "ERROR: can't write '" << get_option("out") << "'" << std::endl;
+				return 1;
+			}
+		}
+
+		return scan_pages(collect(_args), "headers", file.is_open() ? file : std::cout, [](const path& _path) {
+			header h{};
+			auto _err = scanner::probe(_path, h);
+
+			std::stringstream out;
+			if (_err == scanner::err::none) {
+				out << "{\"file\":\"" << json::escape(_path.u8string()) << "\""
+					<< ",\"version\":" << static_cast<int>(h.version)
+					<< ",\"width\":" << h.size.x
+					<< ",\"height\":" << h.size.y
+					<< ",\"length\":" << h.data_len
+					<< ",\"title\":\"" << json::escape(h.title) << "\""
+					<< ",\"base_url\":\"" << json::escape(h.base_url) << "\""
+					<< ",\"page_url\":\"" << json::escape(h.page_url) << "\""
+					<< "}\n";
+			}
+
+			return page_output{ out.str(), 1, _err };
+		});
+	}
+
+	int cli::scan_pages(const std::vector<path>& files, const char* records, std::ostream& out, const std::function<page_output(const path&)>& job) {
+		size_t workers = 0;
+		if (!get_number("workers", workers))
+			return usage();
+
+		pool _pool(workers);
+
+		sf::Clock clock;
+		size_t count = 0, failed = 0;
+
+		// pages are scanned in parallel, a bounded window ahead of the in-order output
+		std::deque<std::future<page_output>> window;
+		size_t next = 0, done = 0;
+
+		while (done < files.size()) {
+			while (next < files.size() && window.size() < _pool.size() * 4) {
+				const path& file = files[next++];
+				window.push_back(_pool.submit([&job, &file] { return job(file); }));
+			}
+
+			auto r = window.front().get();
+			window.pop_front();
+
+			if (r.err != scanner::err::none) {
+				std::cerr << "WARNING: '" << files[done].u8string() << "' failed to scan (" << r.err << ")" << std::endl;
+				failed++;
+			}
+			else if (!r.failed.empty()) {
+				std::cerr << "WARNING: '" << files[done].u8string() << "' failed, " << r.failed << std::endl;
+				failed++;
+			}
+			else {
+				out << r.data;
+				count += r.records;
+			}
+
+			done++;
+		}
+
+		out.flush();
+
+		double seconds = clock.getElapsedTime().asSeconds();
+		std::cerr << files.size() << " pages, " << count << " " << records << ", " << failed << " failed in " << seconds << "s ("
+			<< (seconds > 0 ? files.size() / seconds : 0) << " pages/s)" << std::endl;
+
+		return failed == 0 ? 0 : 1;
+	}
+
+	template <typename T>
+	bool cli::get_number(const std::string& name, T& value) const {
+		std::string s = get_option(name);
+		if (s.empty() || parse_number(s, value))
+			return true;
+
+		std::cerr << "ERROR: --" << name << " expects a number, not '" << s << "'" << std::endl;
+		return false;
+	}
+
+	std::string cli::get_option(const std::string& name, const std::string& def) const {
+		auto i = _options.find(name);
+		return i == _options.end() || i->second.empty() ? def : i->second;
+	}
+
+	bool cli::has_option(const std::string& name) const {
+		return _options.count(name) != 0;
+	}
+
+	std::vector<path> cli::collect(const std::vector<std::string>& args) const {
+		std::vector<path> ret;
+
+		for (const auto& i : args) {
+			path p(i);
+
+			if (fs::is_directory(p)) {
+				for (const auto& j : fs::recursive_directory_iterator(p))
+					if (fs::is_regular_file(j.path()) && j.path().extension() == ".obml")
+						ret.push_back(j.path());
+			}
+			else if (fs::exists(p))
+				ret.push_back(p);
+			else
+				std::cerr << "WARNING: '" << i << "' not found" << std::endl;
+		}
+
+		std::sort(ret.begin(), ret.end());
+		return ret;
+	}
+
+	std::map<path, path> cli::output_names(const std::vector<path>& files, const path& dest, const char* extension) const {
+		std::map<path, path> ret;
+		std::set<std::string> used;
+
+		// "." and the empty name of a trailing separator don't count
+		auto parts = [](const path& p) {
+			std::vector<path> ret;
+			for (const auto& i : p)
+				if (!i.empty() && i != ".")
+					ret.push_back(i);
+			return ret;
+		};
+
+		for (const auto& file : files) {
+			if (ret.count(file) != 0)
+				continue;
+
+			// collect() walks directories from the argument as given, so its components lead the file's
+			auto f = parts(file);
+			path name = file.filename();
+
+			for (const auto& i : _args) {
+				if (!fs::is_directory(i))
+					continue;
+
+				auto r = parts(i);
+				if (r.size() >= f.size() || !std::equal(r.begin(), r.end(), f.begin()))
+					continue;
+
+				name.clear();
+				for (size_t j = r.size(); j < f.size(); j++)
+					name /= f[j];
+				break;
+			}
+
+			name.replace_extension(extension);
+
+			// two arguments can hold the same relative path, later ones get a numbered name
+			path unique = name;
+			for (size_t n = 2; !used.insert(unique.generic_u8string()).second; n++)
+				unique = name.parent_path() / (name.stem().u8string() + "-" + std::to_string(n) + extension);
+
+			ret[file] = dest / unique;
+		}
+
+		// made here rather than on the pool: the jobs only open their files, and report the ones that can't be
+		std::error_code ec;
+		for (const auto& i : ret)
+			fs::create_directories(i.second.parent_path(), ec);
+
+		return ret;
+	}
+};
\ No newline at end of file
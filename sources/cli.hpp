@@ -0,0 +1,54 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// command line front-end for headless batch tools; no command opens the viewer
+	class cli : private sf::NonCopyable {
+	public:
+		cli(int argc, char* argv[]);
+
+		bool has_command() const;
+		int run();
+
+	private:
+		struct page_output {
+			std::string data;	// written out in corpus order
+			size_t records;
+			scanner::err err;
+			std::string failed;	// set when the page scanned but its output couldn't be written
+		};
+
+		std::string _command;
+		std::vector<std::string> _args;
+		std::map<std::string, std::string> _options;
+
+		int usage();
+		int run_bench();
+		int run_generate();
+		int run_serve();
+		int run_stats();
+		int run_dump();
+		int run_links();
+		int run_text();
+		int run_index();
+		int run_query();
+		int run_probe();
+
+		// job runs for every file on a thread pool; outputs keep the file order
+		int scan_pages(const std::vector<path>& files, const char* records, std::ostream& out, const std::function<page_output(const path&)>& job);
+
+		std::string get_option(const std::string& name, const std::string& def = "") const;
+		bool has_option(const std::string& name) const;
+
+		// leaves value as it is when the option is absent; false, with an error on stderr, when it isn't a number
+		template <typename T>
+		bool get_number(const std::string& name, T& value) const;
+
+		// expand files and directories (recursively, *.obml) into a sorted list
+		std::vector<path> collect(const std::vector<std::string>& args) const;
+
+		// per-file output names under dest: the path below the directory argument it came from, made unique
+		std::map<path, path> output_names(const std::vector<path>& files, const path& dest, const char* extension) const;
+	};
+};
\ No newline at end of file
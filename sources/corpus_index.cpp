@@ -0,0 +1,479 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	static const char segment_magic[8] = { 'O', 'B', 'M', 'L', 'I', 'D', 'X', '1' };
+	static const char* segment_ext = ".obix";
+
+	// on-disk record sizes, fields are written one by one without padding
+	static const uint64_t header_size = 8 + 4 + 4 + 8 * 4;
+	static const uint64_t page_entry_size = 8 + 4;
+	static const uint64_t term_entry_size = 8 + 4 + 8 + 4;
+	static const uint64_t posting_size = 4 + 1 + 2 + 4 + 2 + 4;
+
+	template<typename T> static void write(std::ostream& out, const T& value) {
+		out.write(reinterpret_cast<const char*>(&value), sizeof value);
+	}
+
+	template<typename T> static bool read(std::istream& in, T& value) {
+		return in.read(reinterpret_cast<char*>(&value), sizeof value).good();
+	}
+
+	template<typename T> static const char* take(const char* data, T& value) {
+		memcpy(&value, data, sizeof value);
+		return data + sizeof value;
+	}
+
+	// the same file however it was named on the command line
+	static std::string identity(const path& _path) {
+		std::error_code ec;
+		path canonical = fs::canonical(_path, ec);
+
+		return (ec ? _path : canonical).u8string();
+	}
+
+	// the terms of one page, built on a worker thread
+	class corpus_index::collector : public scanner::visitor {
+	public:
+		std::unordered_map<std::string, std::vector<posting>> terms;
+		scanner::err err = scanner::err::none;
+
+		void on_header(const header& h) override {
+			_base = h.base_url.empty() ? h.page_url : h.base_url;
+			add(h.title, field::title, {});
+		}
+
+		void on_link(const scanner::link_record& l) override {
+			// resolved, so host names are searchable on relative links too
+			if (!l.href.empty())
+				add(uri::resolve(_base, l.href), field::href, l.regions.empty() ? rect() : l.regions.front());
+		}
+
+		void on_text(const scanner::text_record& t) override {
+			add(t.data, field::text, t.bounds);
+		}
+
+	private:
+		std::string _base;
+
+		static bool same(const posting& a, const posting& b) {
+			return a.field == b.field && a.left == b.left && a.top == b.top && a.width == b.width && a.height == b.height;
+		}
+
+		void add(std::string_view data, uint8_t f, const rect& bounds) {
+			posting p{ 0, f, bounds.left, bounds.top, bounds.width, bounds.height };
+
+			tokenizer::split(data, [&](std::string_view word, size_t, size_t) {
+				auto& postings = terms[std::string(word)];
+
+				// a word repeated within one record is one posting
+				if (postings.empty() || !same(postings.back(), p))
+					postings.push_back(p);
+			});
+		}
+	};
+
+	// a segment file, searched in place
+	class corpus_index::segment {
+	public:
+		uint32_t pages = 0;
+		path name;
+
+		bool broken = false; // a read failed: truncated or not an index
+		bool reported = false;
+
+		bool open(const path& _path) {
+			name = _path;
+			_in.open(_path, std::ios::in | std::ios::binary | std::ios::ate);
+			_size = static_cast<uint64_t>(std::max<std::streamoff>(_in.tellg(), 0));
+			_in.seekg(0);
+
+			char magic[8];
+			if (!_in.read(magic, sizeof magic).good() || memcmp(magic, segment_magic, sizeof magic) != 0)
+				return false;
+
+			return read(_in, pages) && read(_in, _terms)
+				&& read(_in, _pages_off) && read(_in, _terms_off)
+				&& read(_in, _postings_off) && read(_in, _strings_off);
+		}
+
+		bool get_page(uint32_t id, std::string& out) {
+			uint64_t off = 0;
+			uint32_t len = 0;
+
+			return seek(_pages_off + id * page_entry_size) && read_checked(off) && read_checked(len)
+				&& read_string(off, len, out);
+		}
+
+		// binary search of the sorted term table
+		bool lookup(const std::string& term, std::vector<posting>& out) {
+			uint32_t lo = 0, hi = _terms;
+			std::string found;
+
+			while (lo < hi) {
+				uint32_t mid = lo + (hi - lo) / 2;
+
+				uint64_t off = 0, postings = 0;
+				uint32_t len = 0, count = 0;
+
+				if (!seek(_terms_off + mid * term_entry_size)
+					|| !read_checked(off) || !read_checked(len) || !read_checked(postings) || !read_checked(count)
+					|| !read_string(off, len, found))
+					return false;
+
+				int cmp = found.compare(term);
+
+				if (cmp < 0)
+					lo = mid + 1;
+				else if (cmp > 0)
+					hi = mid;
+				else {
+					if (count * posting_size > _size) {
+						broken = true;
+						return false;
+					}
+
+					blob buf(count * posting_size);
+
+					if (!seek(_postings_off + postings * posting_size) || !read_checked(buf.data(), buf.size()))
+						return false;
+
+					// one read for the whole list, decoded field by field
+					out.resize(count);
+					const char* i = buf.data();
+
+					for (auto& p : out) {
+						i = take(i, p.page);
+						i = take(i, p.field);
+						i = take(i, p.left);
+						i = take(i, p.top);
+						i = take(i, p.width);
+						i = take(i, p.height);
+					}
+
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+	private:
+		std::ifstream _in;
+		uint64_t _size = 0;
+
+		uint32_t _terms = 0;
+		uint64_t _pages_off = 0;
+		uint64_t _terms_off = 0;
+		uint64_t _postings_off = 0;
+		uint64_t _strings_off = 0;
+
+		// a failed read leaves failbit set, every later seek would fail too
+		bool seek(uint64_t off) {
+			_in.clear();
+			_in.seekg(off);
+
+			broken |= !_in.good();
+			return !broken;
+		}
+
+		bool read_checked(char* data, size_t len) {
+			broken |= !_in.read(data, len).good();
+			return !broken;
+		}
+
+		template<typename T> bool read_checked(T& value) {
+			return read_checked(reinterpret_cast<char*>(&value), sizeof value);
+		}
+
+		bool read_string(uint64_t off, uint32_t len, std::string& out) {
+			if (len > _size) {
+				broken = true;
+				return false;
+			}
+
+			out.assign(len, 0);
+			return seek(_strings_off + off) && (len == 0 || read_checked(&out[0], len));
+		}
+	};
+
+	corpus_index::corpus_index(const path& dir) {
+		if (!fs::is_directory(dir))
+			return;
+
+		std::vector<path> files;
+		for (const auto& i : fs::directory_iterator(dir))
+			if (i.path().extension() == segment_ext)
+				files.push_back(i.path());
+
+		std::sort(files.begin(), files.end());
+
+		for (const auto& i : files) {
+			auto s = std::make_unique<segment>();
+
+			if (s->open(i))
+				_segments.push_back(std::move(s));
+			else
+				std::cerr << "WARNING: '" << i.u8string() << "' is not an index segment" << std::endl;
+		}
+	}
+
+	corpus_index::~corpus_index() {
+	}
+
+	bool corpus_index::build(const std::vector<path>& paths, const path& dir, size_t workers, size_t batch) {
+		fs::create_directories(dir);
+
+		// pages already in a segment, or named twice, are indexed once
+		std::unordered_set<std::string> indexed;
+		{
+			corpus_index existing(dir);
+			std::string file;
+
+			for (auto& i : existing._segments)
+				for (uint32_t j = 0; j < i->pages && i->get_page(j, file); j++)
+					indexed.insert(identity(file));
+		}
+
+		std::vector<path> files;
+		for (const auto& i : paths)
+			if (indexed.insert(identity(i)).second)
+				files.push_back(i);
+
+		if (files.size() < paths.size())
+			std::cerr << "Skipped " << paths.size() - files.size() << " pages already indexed" << std::endl;
+
+		// new segments go after the existing ones
+		size_t next = 0;
+		for (const auto& i : fs::directory_iterator(dir))
+			if (i.path().extension() == segment_ext)
+				next++;
+
+		pool _pool(workers);
+		batch = std::max<size_t>(batch, 1);
+
+		for (size_t begin = 0; begin < files.size(); begin += batch) {
+			size_t end = std::min(files.size(), begin + batch);
+			std::vector<std::future<uptr_t<collector>>> jobs;
+
+			for (size_t i = begin; i < end; i++) {
+				jobs.push_back(_pool.submit([&files, i] {
+					TRACE_SCOPE("corpus_index::collect");
+
+					const int sections = scanner::section::links | scanner::section::content;
+					auto c = std::make_unique<collector>();
+
+					scanner _scanner(scanner::load(files[i], sections));
+					c->err = _scanner.scan(*c, sections);
+
+					return c;
+				}));
+			}
+
+			std::vector<std::string> pages;
+			std::unordered_map<std::string, std::vector<posting>> terms;
+
+			for (size_t i = begin; i < end; i++) {
+				auto c = jobs[i - begin].get();
+
+				if (c->err != scanner::err::none) {
+					std::cerr << "WARNING: '" << files[i].u8string() << "' failed to scan (" << c->err << ")" << std::endl;
+					continue;
+				}
+
+				auto id = static_cast<uint32_t>(pages.size());
+				pages.push_back(files[i].u8string());
+
+				for (auto& t : c->terms) {
+					for (auto& p : t.second)
+						p.page = id;
+
+					auto& postings = terms[t.first];
+					postings.insert(postings.end(), t.second.begin(), t.second.end());
+				}
+			}
+
+			std::stringstream name;
+			name << "segment-" << std::setw(6) << std::setfill('0') << next++ << segment_ext;
+
+			if (!write_segment(dir / name.str(), pages, terms))
+				return false;
+
+			std::cerr << "Indexed " << end << "/" << files.size() << " pages (" << terms.size() << " terms in " << name.str() << ")" << std::endl;
+		}
+
+		return true;
+	}
+
+	bool corpus_index::write_segment(const path& _path, const std::vector<std::string>& pages, std::unordered_map<std::string, std::vector<posting>>& terms) {
+		TRACE_SCOPE("corpus_index::write_segment");
+
+		std::vector<const std::pair<const std::string, std::vector<posting>>*> sorted;
+		sorted.reserve(terms.size());
+
+		uint64_t postings = 0;
+		for (const auto& i : terms) {
+			sorted.push_back(&i);
+			postings += i.second.size();
+		}
+
+		std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->first < b->first; });
+
+		uint64_t pages_off = header_size;
+		uint64_t terms_off = pages_off + pages.size() * page_entry_size;
+		uint64_t postings_off = terms_off + sorted.size() * term_entry_size;
+		uint64_t strings_off = postings_off + postings * posting_size;
+
+		std::ofstream out(_path, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!out.is_open())
+			return false;
+
+		out.write(segment_magic, sizeof segment_magic);
+		write(out, static_cast<uint32_t>(pages.size()));
+		write(out, static_cast<uint32_t>(sorted.size()));
+		write(out, pages_off);
+		write(out, terms_off);
+		write(out, postings_off);
+		write(out, strings_off);
+
+		uint64_t string = 0;
+
+		for (const auto& i : pages) {
+			write(out, string);
+			write(out, static_cast<uint32_t>(i.size()));
+			string += i.size();
+		}
+
+		uint64_t posting = 0;
+
+		for (const auto* i : sorted) {
+			write(out, string);
+			write(out, static_cast<uint32_t>(i->first.size()));
+			write(out, posting);
+			write(out, static_cast<uint32_t>(i->second.size()));
+
+			string += i->first.size();
+			posting += i->second.size();
+		}
+
+		for (const auto* i : sorted) {
+			for (const auto& p : i->second) {
+				write(out, p.page);
+				write(out, p.field);
+				write(out, p.left);
+				write(out, p.top);
+				write(out, p.width);
+				write(out, p.height);
+			}
+		}
+
+		for (const auto& i : pages)
+			out.write(i.data(), i.size());
+
+		for (const auto* i : sorted)
+			out.write(i->first.data(), i->first.size());
+
+		return out.good();
+	}
+
+	std::vector<corpus_index::result> corpus_index::query(const std::vector<std::string>& terms, size_t limit) {
+		TRACE_SCOPE("corpus_index::query");
+
+		std::vector<result> ret;
+		if (terms.empty())
+			return ret;
+
+		for (auto& s : _segments) {
+			if (s->broken)
+				continue;
+
+			// postings are stored in page order, so terms intersect in one merge pass each
+			std::vector<std::pair<uint32_t, std::vector<match>>> pages;
+			std::vector<posting> postings;
+
+			for (size_t t = 0; t < terms.size(); t++) {
+				if (!s->lookup(terms[t], postings)) {
+					pages.clear();
+					break;
+				}
+
+				std::vector<std::pair<uint32_t, std::vector<match>>> found;
+				auto page = pages.begin();
+
+				for (const auto& p : postings) {
+					if (t > 0) {
+						while (page != pages.end() && page->first < p.page)
+							++page;
+
+						if (page == pages.end())
+							break;
+
+						if (page->first != p.page)
+							continue;
+					}
+
+					if (found.empty() || found.back().first != p.page) {
+						found.push_back({ p.page, {} });
+
+						if (t > 0)
+							found.back().second = std::move(page->second);
+					}
+
+					found.back().second.push_back({ t, p });
+				}
+
+				pages = std::move(found);
+
+				if (pages.empty())
+					break;
+			}
+
+			std::string file;
+
+			for (auto& i : pages) {
+				if (!s->get_page(i.first, file))
+					break; // the segment is broken from here on
+
+				ret.push_back({ file, std::move(i.second) });
+			}
+		}
+
+		// reported once, the segment keeps being skipped
+		for (auto& s : _segments) {
+			if (s->broken && !s->reported) {
+				std::cerr << "WARNING: index segment '" << s->name.u8string() << "' is damaged, its pages are skipped" << std::endl;
+				s->reported = true;
+			}
+		}
+
+		std::stable_sort(ret.begin(), ret.end(), [](const result& a, const result& b) {
+			return a.matches.size() > b.matches.size();
+		});
+
+		if (ret.size() > limit)
+			ret.resize(limit);
+
+		return ret;
+	}
+
+	size_t corpus_index::get_segments() const {
+		return _segments.size();
+	}
+
+	size_t corpus_index::get_pages() const {
+		size_t ret = 0;
+		for (const auto& i : _segments)
+			ret += i->pages;
+
+		return ret;
+	}
+
+	const char* corpus_index::field_name(uint8_t f) {
+		switch (f) {
+		case field::text: return "text";
+		case field::title: return "title";
+		case field::href: return "href";
+		}
+
+		return "unknown";
+	}
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// on-disk inverted index over saved pages: term -> (page, field, bounds)
+	//
+	// the index is a directory of self-contained segments, one per indexing batch,
+	// so building never holds more than a batch in memory and re-runs only add segments;
+	// a segment is a sorted term table searched in place, queries read a few KB per term
+	class corpus_index : private sf::NonCopyable {
+	public:
+		enum field : uint8_t {
+			text,
+			title,
+			href
+		};
+
+		struct posting {
+			uint32_t page; // within its segment
+			uint8_t field;
+
+			int16_t left;
+			int32_t top;
+			int16_t width;
+			int32_t height;
+		};
+
+		struct match {
+			size_t term; // into the query terms
+			posting where;
+		};
+
+		struct result {
+			std::string file;
+			std::vector<match> matches;
+		};
+
+		explicit corpus_index(const path& dir);
+		~corpus_index();
+
+		// scan files on workers threads and write a segment per batch pages into dir;
+		// files some segment there already holds are skipped
+		static bool build(const std::vector<path>& files, const path& dir, size_t workers, size_t batch);
+
+		// pages containing every term, most matches first
+		std::vector<result> query(const std::vector<std::string>& terms, size_t limit);
+
+		size_t get_segments() const;
+		size_t get_pages() const;
+
+		static const char* field_name(uint8_t f);
+
+	private:
+		class collector;
+		class segment;
+
+		std::vector<uptr_t<segment>> _segments;
+
+		static bool write_segment(const path& _path, const std::vector<std::string>& pages, std::unordered_map<std::string, std::vector<posting>>& terms);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	void stats::on_header(const header& h) {
+		pages++;
+		bytes += h.data_len;
+	}
+
+	void stats::on_link(const scanner::link_record& l) {
+		links++;
+		regions += l.regions.size();
+
+		auto i = link_types.find(l.type);
+		if (i == link_types.end())
+			link_types.emplace(std::string(l.type), 1);
+		else
+			i->second++;
+	}
+
+	void stats::on_tile(const tile& t) {
+		tiles++;
+	}
+
+	void stats::on_image(const image& i) {
+		images++;
+	}
+
+	void stats::on_text(const scanner::text_record& t) {
+		texts++;
+		text_bytes += t.data.size();
+	}
+
+	void stats::on_form(const scanner::form_record& f) {
+		forms++;
+	}
+
+	void stats::on_blob(const scanner::blob_record& b) {
+		blobs++;
+		blob_bytes += b.data.size();
+	}
+
+	void stats::print(std::ostream& out, double seconds) const {
+		auto rate = [&](double n) { return seconds > 0 ? n / seconds : 0.0; };
+
+		out << std::fixed << std::setprecision(1)
+			<< "pages:      " << pages << " (" << rate(pages) << " pages/s)" << std::endl
+			<< "bytes:      " << bytes << " (" << rate(bytes) / (1024.0 * 1024.0) << " MB/s)" << std::endl
+			<< "links:      " << links << " (" << regions << " regions)" << std::endl
+			<< "tiles:      " << tiles << std::endl
+			<< "images:     " << images << " tiles, " << blobs << " blobs, " << blob_bytes << " bytes" << std::endl
+			<< "texts:      " << texts << " (" << text_bytes << " bytes)" << std::endl
+			<< "forms:      " << forms << std::endl
+		;
+
+		for (const auto& i : link_types)
+			out << "link type '" << i.first << "': " << i.second << std::endl;
+	}
+
+	dumper::dumper(std::ostream& out, int sections) :
+		_out(out),
+		_all(sections == scanner::section::all)
+	{
+	}
+
+	int dumper::parse_records(const std::string& records) {
+		if (records == "links")
+			return scanner::section::links;
+		else if (records == "text")
+			return scanner::section::content;
+		else if (records == "all")
+			return scanner::section::all;
+
+		return 0;
+	}
+
+	void dumper::on_link(const scanner::link_record& l) {
+		if (_all) {
+			_out << "link\t" << l.tag << "\t";
+			for (const auto& i : l.regions)
+				write_bounds(i);
+		}
+
+		_out << l.type << "\t" << l.href << "\n";
+	}
+
+	void dumper::on_tile(const tile& t) {
+		if (!_all)
+			return;
+
+		_out << "tile\t";
+		write_bounds(t.bounds);
+		_out << std::hex << std::setw(8) << std::setfill('0') << t.color.toInteger() << std::dec << "\n";
+	}
+
+	void dumper::on_image(const image& i) {
+		if (!_all)
+			return;
+
+		_out << "image\t";
+		write_bounds(i.bounds);
+		_out << i.addr << "\n";
+	}
+
+	void dumper::on_text(const scanner::text_record& t) {
+		if (_all) {
+			_out << "text\t";
+			write_bounds(t.bounds);
+			_out << static_cast<int>(t.font) << "\t";
+		}
+
+		_out << t.data << "\n";
+	}
+
+	void dumper::on_form(const scanner::form_record& f) {
+		if (!_all)
+			return;
+
+		_out << "form\t";
+		write_bounds(f.bounds);
+		_out << f.type << "\t" << f.id << "\t" << f.value << "\n";
+	}
+
+	void dumper::on_blob(const scanner::blob_record& b) {
+		if (!_all)
+			return;
+
+		_out << "blob\t" << b.addr << "\t" << b.data.size() << "\n";
+	}
+
+	void dumper::write_bounds(const rect& r) {
+		_out << r.left << "," << r.top << "," << r.width << "," << r.height << "\t";
+	}
+
+	link_writer::link_writer(std::ostream& out, const std::string& file) :
+		_out(out),
+		_file(json::escape(file))
+	{
+	}
+
+	void link_writer::on_header(const header& h) {
+		_base = h.base_url.empty() ? h.page_url : h.base_url;
+	}
+
+	void link_writer::on_link(const scanner::link_record& l) {
+		_out << "{\"file\":\"" << _file << "\""
+			<< ",\"type\":\"" << json::escape(std::string(l.type)) << "\""
+			<< ",\"href\":\"" << json::escape(l.href.empty() ? std::string() : uri::resolve(_base, l.href)) << "\""
+			<< ",\"regions\":[";
+
+		bool first = true;
+		for (const auto& i : l.regions) {
+			_out << (first ? "" : ",") << "[" << i.left << "," << i.top << "," << i.width << "," << i.height << "]";
+			first = false;
+		}
+
+		_out << "]}\n";
+		_count++;
+	}
+
+	size_t link_writer::get_count() const {
+		return _count;
+	}
+
+	text_writer::text_writer(bool lines) : _lines(lines) {
+	}
+
+	void text_writer::on_text(const scanner::text_record& t) {
+		if (!t.data.empty())
+			_runs.push_back({ t.bounds, t.data });
+	}
+
+	void text_writer::write(std::ostream& out) {
+		std::stable_sort(_runs.begin(), _runs.end(), [](const run& a, const run& b) {
+			return a.bounds.top != b.bounds.top ? a.bounds.top < b.bounds.top : a.bounds.left < b.bounds.left;
+		});
+
+		if (_lines)
+			write_lines(out);
+		else {
+			for (const auto& i : _runs)
+				out << i.data << "\n";
+		}
+	}
+
+	size_t text_writer::get_count() const {
+		return _runs.size();
+	}
+
+	void text_writer::write_lines(std::ostream& out) const {
+		auto is_space = [](char c) { return c == ' ' || c == '\t'; };
+
+		std::vector<const run*> line;
+		int32_t line_top = 0, line_bottom = 0, last_bottom = -1;
+
+		auto flush = [&] {
+			if (line.empty())
+				return;
+
+			std::sort(line.begin(), line.end(), [](const run* a, const run* b) {
+				return a->bounds.left < b->bounds.left;
+			});
+
+			// a gap taller than the line itself starts a paragraph
+			if (last_bottom >= 0 && line_top - last_bottom > line_bottom - line_top)
+				out << "\n";
+
+			int32_t right = line.front()->bounds.left;
+
+			for (const auto* i : line) {
+				bool touching = i->bounds.left - right < 1;
+
+				if (i != line.front() && !touching && !is_space(i->data.front()))
+					out << " ";
+
+				out << i->data;
+				right = i->bounds.right();
+			}
+
+			out << "\n";
+
+			last_bottom = line_bottom;
+			line.clear();
+		};
+
+		for (const auto& i : _runs) {
+			float center = i.bounds.top + i.bounds.height / 2.f;
+
+			// runs are sorted by top: one belongs to the line while it starts above its bottom half
+			if (!line.empty() && center > line_bottom)
+				flush();
+
+			if (line.empty()) {
+				line_top = i.bounds.top;
+				line_bottom = i.bounds.bottom();
+			}
+			else
+				line_bottom = std::max(line_bottom, i.bounds.bottom());
+
+			line.push_back(&i);
+		}
+
+		flush();
+	}
+};
\ No newline at end of file
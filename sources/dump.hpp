@@ -0,0 +1,97 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// record counts over any number of scanned pages, for --stats
+	class stats : public scanner::visitor {
+	public:
+		size_t pages = 0;
+		size_t bytes = 0;
+
+		size_t links = 0;
+		size_t regions = 0;
+		size_t tiles = 0;
+		size_t images = 0;
+		size_t texts = 0;
+		size_t text_bytes = 0;
+		size_t forms = 0;
+		size_t blobs = 0;
+		size_t blob_bytes = 0;
+
+		std::map<std::string, size_t, std::less<>> link_types;
+
+		void on_header(const header& h) override;
+		void on_link(const scanner::link_record& l) override;
+		void on_tile(const tile& t) override;
+		void on_image(const image& i) override;
+		void on_text(const scanner::text_record& t) override;
+		void on_form(const scanner::form_record& f) override;
+		void on_blob(const scanner::blob_record& b) override;
+
+		void print(std::ostream& out, double seconds) const;
+	};
+
+	// one tab-separated line per record, for --dump
+	class dumper : public scanner::visitor {
+	public:
+		dumper(std::ostream& out, int sections);
+
+		// links | text | all
+		static int parse_records(const std::string& records);
+
+		void on_link(const scanner::link_record& l) override;
+		void on_tile(const tile& t) override;
+		void on_image(const image& i) override;
+		void on_text(const scanner::text_record& t) override;
+		void on_form(const scanner::form_record& f) override;
+		void on_blob(const scanner::blob_record& b) override;
+
+	private:
+		std::ostream& _out;
+		bool _all;
+
+		void write_bounds(const rect& r);
+	};
+
+	// one JSON line per link with its href resolved against the page, for --links
+	class link_writer : public scanner::visitor {
+	public:
+		link_writer(std::ostream& out, const std::string& file);
+
+		void on_header(const header& h) override;
+		void on_link(const scanner::link_record& l) override;
+
+		size_t get_count() const;
+
+	private:
+		std::ostream& _out;
+		std::string _file; // escaped
+		std::string _base;
+		size_t _count = 0;
+	};
+
+	// text runs in reading order, for --text
+	class text_writer : public scanner::visitor {
+	public:
+		// lines: join runs sharing a line, blank line between paragraphs
+		explicit text_writer(bool lines);
+
+		void on_text(const scanner::text_record& t) override;
+
+		void write(std::ostream& out);
+
+		size_t get_count() const;
+
+	private:
+		struct run {
+			rect bounds;
+			std::string_view data; // into the scanned buffer
+		};
+
+		std::vector<run> _runs;
+		bool _lines;
+
+		void write_lines(std::ostream& out) const;
+	};
+};
\ No newline at end of file
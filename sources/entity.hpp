@@ -3,18 +3,61 @@
 #include "main.hpp"
 
 namespace obml_renderer {
+	// page geometry as the file stores it: x and width are shorts, y and height mediums;
+	// converted to floats only where vertices are built
+	struct rect {
+		int32_t top{0};
+		int32_t height{0};
+		int16_t left{0};
+		int16_t width{0};
+
+		rect() = default;
+		rect(const sf::Vector2i& position, const sf::Vector2i& size) :
+			top(position.y),
+			height(size.y),
+			left(static_cast<int16_t>(position.x)),
+			width(static_cast<int16_t>(size.x))
+		{
+		}
+
+		int32_t right() const { return left + width; }
+		int32_t bottom() const { return top + height; }
+
+		bool contains(int32_t x, int32_t y) const {
+			return x >= left && x < right() && y >= top && y < bottom();
+		}
+
+		bool contains(const rect& r) const {
+			return left <= r.left && r.right() <= right() && top <= r.top && r.bottom() <= bottom();
+		}
+
+		bool intersects(const rect& r) const {
+			return left < r.right() && r.left < right() && top < r.bottom() && r.top < bottom();
+		}
+
+		sf::FloatRect to_float() const {
+			return {
+				static_cast<float>(left), static_cast<float>(top),
+				static_cast<float>(width), static_cast<float>(height)
+			};
+		}
+	};
+
 	struct tile {
-		sf::FloatRect bounds;
+		rect bounds;
 		sf::Color color;
 	};
 
 	struct image : tile {
+		static const uint32_t no_slot = 0xFFFFFFFF;
+
 		uint32_t addr{0};
+		uint32_t slot{no_slot}; // into the page's images, resolved once parsing is done
 	};
 
 	struct text : tile {
 		int8_t font;
-		std::string data;
+		istring data;
 	};
 
 	struct form : tile {
@@ -24,12 +67,12 @@ namespace obml_renderer {
 	};
 
 	struct url {
-		std::string type;
-		std::string href;
+		istring type;
+		istring href;
 	};
 
 	struct link {
-		std::list<sf::FloatRect> regions;
+		std::vector<rect> regions;
 		url target;
 	};
 
@@ -49,9 +92,17 @@ namespace obml_renderer {
 	template<typename T> using uptr_t = std::unique_ptr<T>;
 	template<typename T> using sptr_t = std::shared_ptr<T>;
 
+	// a decoded blob; pages keep them in addr order, as the S section stores them
+	struct image_slot {
+		uint32_t addr;
+		sptr_t<sf::Texture> texture; // shared through image_cache
+		bool opaque; // every decoded pixel has full alpha
+	};
+
 	using path = std::experimental::filesystem::v1::path;
-	using images = std::unordered_map<uint32_t, uptr_t<sf::Texture>>;
+	using images = std::vector<image_slot>;
 	using tiles = std::list<std::variant<tile, image, text, form>>;
 	using links = std::list<link>;
+	using charsets = std::map<int8_t, std::unordered_set<sf::Uint32>>;
 	using blob = std::vector<char>;
 };
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	static const char* words[] = {
+		"opera", "mini", "page", "render", "binary", "markup", "link", "image",
+		"|", "\xC2\xBB", "\xD1\x81\xD1\x82\xD1\x80\xD0\xB0\xD0\xBD\xD0\xB8\xD1\x86\xD0\xB0", // "|", "»", "страница"
+		"\xD0\xBD\xD0\xBE\xD0\xB2\xD0\xBE\xD1\x81\xD1\x82\xD0\xB8" // "новости"
+	};
+
+	generator::generator(const options& opts) : _opts(opts), _rng(opts.seed) {
+		if (_opts.size.y <= 0)
+			_opts.size.y = static_cast<int>(std::max<size_t>(400, _opts.tiles * 8));
+
+		_opts.size.y = std::min(_opts.size.y, 0x7FFFFF);
+		_opts.size.x = std::min(std::max(_opts.size.x, 16), 0x7FFF);
+	}
+
+	generator::options generator::for_size(size_t bytes, options opts) {
+		// approximate encoded size of one B record with its share of T/I/link records
+		const double per_tile = 15.0
+			+ opts.text_density * (16.0 + 24.0)
+			+ opts.image_density * 21.0
+			+ opts.link_density * 48.0;
+
+		// images take at most half of small pages
+		size_t per_image = 54 + ((opts.image_size.x * 3 + 3) & ~3) * opts.image_size.y + 2;
+		opts.images = std::min(opts.images, bytes / 2 / per_image);
+
+		size_t image_bytes = opts.images * per_image;
+		size_t budget = bytes > image_bytes + 256 ? bytes - image_bytes - 256 : 0;
+
+		opts.tiles = std::max<size_t>(1, static_cast<size_t>(budget / per_tile));
+		return opts;
+	}
+
+	bool generator::generate(const path& dest) {
+		_writer = writer();
+		_image_refs.clear();
+
+		write_header();
+		write_metadata();
+		write_links();
+		write_content();
+		write_images();
+
+		size_t len = _writer.tell();
+		if (len > max_size + 3) {
+			std::cout << "ERROR: generated page is " << len << " bytes, OBML v6 lengths are limited to " << max_size << std::endl;
+			return false;
+		}
+
+		_writer.patch_medium(0, static_cast<int32_t>(len - 3));
+
+		return dest.empty() || _writer.save(dest);
+	}
+
+	const blob& generator::get_data() const {
+		return _writer.get_data();
+	}
+
+	void generator::write_header() {
+		_writer.write_medium(0); // data_len, patched when done
+		_writer.write_byte(parser::ver::v6);
+		_writer.write_coord(_opts.size);
+
+		// S\x00\x00\xFF\xFF
+		const char unk[] = { 'S', 0, 0, '\xFF', '\xFF' };
+		for (char i : unk)
+			_writer.write_byte(i);
+
+		std::stringstream title;
+		title << "synthetic " << _opts.tiles << " tiles (seed " << _opts.seed << ")";
+
+		_writer.write_string(title.str());
+		_writer.write_blob(nullptr, 0);
+		_writer.write_string("http://example.com/");
+		_writer.write_string("http://example.com/synthetic.html");
+
+		_writer.write_byte(19);
+	}
+
+	void generator::write_metadata() {
+		_writer.write_byte('M');
+		_writer.write_byte('u');
+		_writer.write_zero(7);
+
+		_writer.write_byte('M');
+		_writer.write_byte('S');
+		_writer.write_blob_alt(nullptr, 0);
+	}
+
+	void generator::write_links() {
+		_writer.write_byte('S');
+		size_t size_pos = _writer.tell();
+		_writer.write_medium(0);
+
+		size_t begin = _writer.tell();
+		size_t count = static_cast<size_t>(_opts.tiles * _opts.link_density);
+
+		auto write_regions = [this](int8_t n) {
+			_writer.write_byte(n);
+			for (int8_t i = 0; i < n; i++) {
+				sf::Vector2i p = random_point(_opts.size.y);
+				_writer.write_coord(p);
+				_writer.write_coord({ 8 + static_cast<int>(_rng() % 120), 12 + static_cast<int>(_rng() % 8) });
+			}
+		};
+
+		for (size_t i = 0; i < count; i++) {
+			switch (_rng() % 10) {
+			case 0: { // drop-down list data
+				_writer.write_byte('\0');
+				_writer.write_zero(1);
+				_writer.write_byte(2);
+				for (int j = 0; j < 2; j++) {
+					_writer.write_string("option");
+					_writer.write_blob(nullptr, 0);
+				}
+			}
+					break;
+
+			case 1:
+				_writer.write_byte('C');
+				_writer.write_zero(21);
+				break;
+
+			case 2: {
+				_writer.write_byte('I');
+				write_regions(1);
+				_writer.write_blob(nullptr, 0);
+				_writer.write_zero(5);
+			}
+					break;
+
+			case 3: {
+				_writer.write_byte(_rng() % 2 ? 'N' : 'S');
+				write_regions(1);
+				_writer.write_blob(nullptr, 0);
+				_writer.write_blob(nullptr, 0);
+			}
+					break;
+
+			default: {
+				static const char types[] = { 'L', 'L', 'L', 'i', 'P' };
+				std::stringstream href;
+				href << "/page/" << (_rng() % 64) << ".html";
+
+				_writer.write_byte(types[_rng() % sizeof types]);
+				write_regions(static_cast<int8_t>(1 + _rng() % 2));
+				_writer.write_string(_rng() % 4 ? "" : "_blank");
+				_writer.write_url(href.str());
+			}
+			}
+		}
+
+		_writer.patch_medium(size_pos, static_cast<int32_t>(_writer.tell() - begin));
+	}
+
+	void generator::write_content() {
+		const int rows = std::max(1, _opts.size.y / 8);
+		const size_t texts = static_cast<size_t>(_opts.tiles * _opts.text_density);
+		const size_t image_tiles = _opts.images > 0 ? static_cast<size_t>(_opts.tiles * _opts.image_density) : 0;
+
+		size_t text_i = 0, image_i = 0;
+
+		// a page background, then records spread top to bottom
+		_writer.write_byte('B');
+		_writer.write_coord({ 0, 0 });
+		_writer.write_coord(_opts.size);
+		_writer.write_color(sf::Color::White);
+
+		for (size_t i = 0; i < _opts.tiles; i++) {
+			int top = static_cast<int>(static_cast<double>(i) / _opts.tiles * (_opts.size.y - 16));
+			sf::Vector2i p{ static_cast<int>(_rng() % _opts.size.x), top };
+			sf::Vector2i s{ 4 + static_cast<int>(_rng() % (_opts.size.x / 2)), 2 + static_cast<int>(_rng() % 24) };
+
+			_writer.write_byte('B');
+			_writer.write_coord(p);
+			_writer.write_coord(s);
+			_writer.write_color(random_color());
+
+			for (; image_i * _opts.tiles < image_tiles * (i + 1); image_i++) {
+				_writer.write_byte('I');
+				_writer.write_coord(p);
+				_writer.write_coord(_opts.image_size);
+				_writer.write_color(random_color());
+				_writer.write_zero(3);
+
+				_image_refs.push_back(_writer.tell());
+				_writer.write_medium(static_cast<int32_t>(_rng() % _opts.images)); // image index until patched
+			}
+
+			for (; text_i * _opts.tiles < texts * (i + 1); text_i++) {
+				static const int8_t fonts[] = { 2, 2, 2, 3, 4, 5, 6, 6 };
+
+				_writer.write_byte('T');
+				_writer.write_coord({ p.x, top + static_cast<int>(_rng() % 16) });
+				_writer.write_coord({ 60, 16 });
+				_writer.write_color(random_color());
+				_writer.write_byte(fonts[_rng() % sizeof fonts]);
+				_writer.write_string(random_text(1 + _rng() % 4));
+			}
+
+			// occasional records the parser skips
+			switch (_rng() % 64) {
+			case 0: {
+				_writer.write_byte('F');
+				_writer.write_coord(p);
+				_writer.write_coord({ 100, 20 });
+				_writer.write_color(sf::Color::White);
+				_writer.write_short(static_cast<int16_t>(_rng() % 8));
+				_writer.write_string("q");
+				_writer.write_string(random_text(1));
+				_writer.write_byte('\xFF');
+				_writer.write_byte('\xFF');
+				_writer.write_byte('\xFF');
+			}
+					break;
+
+			case 1: _writer.write_byte('L'); _writer.write_zero(9); break;
+			case 2: _writer.write_byte('z'); _writer.write_zero(6); break;
+			case 3: _writer.write_byte('o'); _writer.write_blob(nullptr, 0); break;
+			case 4: _writer.write_byte('M'); _writer.write_zero(2); _writer.write_blob(nullptr, 0); break;
+			}
+		}
+	}
+
+	void generator::write_images() {
+		if (_opts.images == 0)
+			return;
+
+		_writer.write_byte('S');
+		size_t size_pos = _writer.tell();
+		_writer.write_medium(0);
+
+		size_t begin = _writer.tell();
+		std::vector<int32_t> addrs;
+
+		for (size_t i = 0; i < _opts.images; i++) {
+			blob bmp = make_bitmap(_opts.image_size.x, _opts.image_size.y);
+
+			// parser: addr = offset of the length field - 3 (the data_len field)
+			addrs.push_back(static_cast<int32_t>(_writer.tell() - 3));
+			_writer.write_blob(bmp.data(), bmp.size());
+		}
+
+		_writer.patch_medium(size_pos, static_cast<int32_t>(_writer.tell() - begin));
+
+		for (auto i : _image_refs) {
+			const blob& data = _writer.get_data();
+			int32_t index = ((data[i] & 0xFF) << 16) | ((data[i + 1] & 0xFF) << 8) | (data[i + 2] & 0xFF);
+
+			_writer.patch_medium(i, addrs[index]);
+		}
+	}
+
+	sf::Vector2i generator::random_point(int height) {
+		return {
+			static_cast<int>(_rng() % _opts.size.x),
+			static_cast<int>(_rng() % std::max(1, height))
+		};
+	}
+
+	sf::Color generator::random_color(bool opaque) {
+		uint32_t c = _rng();
+		return { static_cast<sf::Uint8>(c), static_cast<sf::Uint8>(c >> 8), static_cast<sf::Uint8>(c >> 16), opaque ? sf::Uint8(255) : static_cast<sf::Uint8>(c >> 24) };
+	}
+
+	std::string generator::random_text(size_t count) {
+		std::string ret;
+
+		for (size_t i = 0; i < count; i++) {
+			if (i > 0)
+				ret += ' ';
+			ret += words[_rng() % (sizeof words / sizeof words[0])];
+		}
+
+		return ret;
+	}
+
+	blob generator::make_bitmap(int w, int h) {
+		// 24-bit BI_RGB, within the 32767 byte limit of an image record
+		int row = (w * 3 + 3) & ~3;
+		while (54 + row * h > 0x7FFF && h > 1) {
+			w = std::max(1, w / 2);
+			h = std::max(1, h / 2);
+			row = (w * 3 + 3) & ~3;
+		}
+
+		blob ret(54 + row * h, 0);
+		auto put = [&ret](size_t pos, uint32_t value, int bytes) {
+			for (int i = 0; i < bytes; i++)
+				ret[pos + i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+		};
+
+		ret[0] = 'B';
+		ret[1] = 'M';
+		put(2, static_cast<uint32_t>(ret.size()), 4);
+		put(10, 54, 4);
+		put(14, 40, 4);
+		put(18, w, 4);
+		put(22, h, 4);
+		put(26, 1, 2);
+		put(28, 24, 2);
+		put(34, row * h, 4);
+
+		sf::Color base = random_color();
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++) {
+				size_t p = 54 + y * row + x * 3;
+				ret[p] = static_cast<char>(base.b + x * 4);
+				ret[p + 1] = static_cast<char>(base.g + y * 4);
+				ret[p + 2] = static_cast<char>(base.r ^ (x * y));
+			}
+
+		return ret;
+	}
+};
\ No newline at end of file
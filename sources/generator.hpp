@@ -0,0 +1,51 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// writes synthetic OBML v6 pages in exactly the layout parser reads
+	class generator : private sf::NonCopyable {
+	public:
+		struct options {
+			sf::Vector2i size{ 240, 0 };		// height 0: derived from the tile count
+			sf::Vector2i image_size{ 32, 32 };
+
+			size_t tiles = 1000;				// B records
+			size_t images = 8;					// distinct images in the S section
+			float text_density = 1.f;			// T records per B record
+			float image_density = 0.05f;		// I records per B record
+			float link_density = 0.1f;			// link records per B record
+
+			uint32_t seed = 1;
+		};
+
+		// largest page the 24-bit length fields can describe
+		static const size_t max_size = 0x7FFFFF;
+
+		explicit generator(const options& opts);
+
+		// scale the record counts so the page comes out near the given size
+		static options for_size(size_t bytes, options opts);
+
+		bool generate(const path& dest);
+		const blob& get_data() const;
+
+	private:
+		options _opts;
+		writer _writer;
+		std::mt19937 _rng;
+
+		std::vector<size_t> _image_refs;	// positions of I record addresses to patch
+
+		void write_header();
+		void write_metadata();
+		void write_links();
+		void write_content();
+		void write_images();
+
+		sf::Vector2i random_point(int height);
+		sf::Color random_color(bool opaque = true);
+		std::string random_text(size_t words);
+		blob make_bitmap(int w, int h);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	bool geometry::merge(rect& a, const rect& b) {
+		bool rows = a.top == b.top && a.height == b.height && a.left <= b.right() && b.left <= a.right();
+		bool columns = a.left == b.left && a.width == b.width && a.top <= b.bottom() && b.top <= a.bottom();
+
+		if (!rows && !columns && !a.contains(b) && !b.contains(a))
+			return false;
+
+		int32_t right = std::max(a.right(), b.right());
+		int32_t bottom = std::max(a.bottom(), b.bottom());
+
+		if (right - std::min(a.left, b.left) > INT16_MAX)
+			return false;
+
+		a.left = std::min(a.left, b.left);
+		a.top = std::min(a.top, b.top);
+		a.width = static_cast<int16_t>(right - a.left);
+		a.height = bottom - a.top;
+
+		return true;
+	}
+
+	geometry::merge_stats geometry::merge_tiles(const tiles& src, tiles& dest) {
+		TRACE_SCOPE("geometry::merge_tiles");
+
+		merge_stats stats;
+		dest.clear();
+
+		auto area = [](const rect& r) {
+			return static_cast<uint64_t>(std::max(0, static_cast<int>(r.width))) * static_cast<uint64_t>(std::max(0, r.height));
+		};
+
+		for (const auto& i : src) {
+			const tile* t = std::get_if<tile>(&i);
+
+			if (t == nullptr || t->color.a != 255 || t->bounds.width <= 0 || t->bounds.height <= 0) {
+				dest.push_back(i);
+				continue;
+			}
+
+			stats.before++;
+			stats.area_before += area(t->bounds);
+
+			// newest first: every tile or image passed on the way is drawn between the
+			// candidate and t, so one touching t ends the search. After a merge the grown
+			// tile keeps looking further back, so cells fold into rows and rows into a block
+			auto target = dest.end(); // the tile holding t's pixels, end() while t stands alone
+			rect r = t->bounds;
+			size_t seen = 0;
+
+			for (auto j = dest.end(); j != dest.begin() && seen < merge_window;) {
+				--j;
+
+				if (std::holds_alternative<text>(*j) || std::holds_alternative<form>(*j))
+					continue; // texts are drawn after every tile, forms not at all
+
+				seen++;
+
+				if (auto c = std::get_if<tile>(&*j)) {
+					if (c->color == t->color) {
+						// painting the same opaque color twice changes nothing, so it never blocks
+						if (merge(c->bounds, r)) {
+							if (target != dest.end())
+								dest.erase(target);
+
+							target = j;
+							r = c->bounds;
+						}
+					}
+					else if (c->bounds.intersects(r))
+						break;
+				}
+				else if (std::get<image>(*j).bounds.intersects(r))
+					break;
+			}
+
+			if (target == dest.end())
+				dest.push_back(*t);
+		}
+
+		for (const auto& i : dest) {
+			const tile* t = std::get_if<tile>(&i);
+
+			if (t != nullptr && t->color.a == 255 && t->bounds.width > 0 && t->bounds.height > 0) {
+				stats.after++;
+				stats.area_after += area(t->bounds);
+			}
+		}
+
+		return stats;
+	}
+
+	namespace geometry {
+		// rects bucketed by the cull_band rows they touch; one spanning several bands is in each
+		class band_index {
+		public:
+			void insert(const rect& r) {
+				uint32_t id = static_cast<uint32_t>(_rects.size());
+				_rects.push_back(r);
+				_seen.push_back(0);
+
+				for (size_t b = first_band(r), last = last_band(r); b <= last; b++) {
+					if (b >= _bands.size())
+						_bands.resize(b + 1);
+
+					_bands[b].push_back(id);
+				}
+			}
+
+			// f(rect) once for every stored rect intersecting r, until it returns false
+			template<typename F>
+			void query(const rect& r, F f) {
+				_stamp++;
+
+				for (size_t b = first_band(r), last = last_band(r); b <= last && b < _bands.size(); b++) {
+					for (uint32_t id : _bands[b]) {
+						if (_seen[id] == _stamp)
+							continue;
+
+						_seen[id] = _stamp;
+
+						if (_rects[id].intersects(r) && !f(_rects[id]))
+							return;
+					}
+				}
+			}
+
+		private:
+			std::vector<rect> _rects;
+			std::vector<std::vector<uint32_t>> _bands;
+			std::vector<uint32_t> _seen; // query stamp per rect, so spanning rects are reported once
+			uint32_t _stamp = 0;
+
+			static size_t first_band(const rect& r) {
+				return static_cast<size_t>(std::max(0, r.top) / cull_band);
+			}
+
+			static size_t last_band(const rect& r) {
+				return static_cast<size_t>(std::max(0, r.bottom() - 1) / cull_band);
+			}
+		};
+	};
+
+	bool geometry::covers(const std::vector<rect>& parts, const rect& r) {
+		// vertical strips between every edge inside r; each must be covered top to bottom
+		std::vector<int32_t> xs{ r.left, r.right() };
+		for (const auto& i : parts) {
+			if (i.left > r.left && i.left < r.right())
+				xs.push_back(i.left);
+			if (i.right() > r.left && i.right() < r.right())
+				xs.push_back(i.right());
+		}
+
+		std::sort(xs.begin(), xs.end());
+		xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+
+		std::vector<std::pair<int32_t, int32_t>> spans;
+
+		for (size_t x = 0; x + 1 < xs.size(); x++) {
+			spans.clear();
+
+			for (const auto& i : parts)
+				if (i.left <= xs[x] && i.right() >= xs[x + 1])
+					spans.push_back({ i.top, i.bottom() });
+
+			std::sort(spans.begin(), spans.end());
+
+			int32_t y = r.top;
+			for (const auto& i : spans) {
+				if (i.first > y)
+					break;
+
+				y = std::max(y, i.second);
+			}
+
+			if (y < r.bottom())
+				return false;
+		}
+
+		return true;
+	}
+
+	geometry::cull_stats geometry::cull_tiles(draw_list& items, const sf::Color& clear, const std::function<bool(const image&)>& opaque) {
+		TRACE_SCOPE("geometry::cull_tiles");
+
+		cull_stats stats;
+		std::vector<bool> culled(items.size(), false);
+
+		// back to front: what is drawn later is indexed before the earlier tiles are tested
+		{
+			band_index later;
+			std::vector<rect> parts;
+
+			for (size_t n = items.size(); n-- > 0;) {
+				const rect* bounds;
+				bool solid;
+
+				if (auto t = std::get_if<tile>(items[n])) {
+					bounds = &t->bounds;
+					solid = t->color.a == 255;
+				}
+				else if (auto i = std::get_if<image>(items[n])) {
+					bounds = &i->bounds;
+					solid = opaque(*i);
+				}
+				else
+					continue;
+
+				stats.tiles++;
+
+				if (bounds->width <= 0 || bounds->height <= 0) {
+					culled[n] = true;
+					stats.covered++;
+					continue;
+				}
+
+				bool contained = false;
+				parts.clear();
+
+				later.query(*bounds, [&](const rect& r) {
+					if (r.contains(*bounds))
+						contained = true;
+					else
+						parts.push_back(r);
+
+					return !contained && parts.size() <= cull_candidates;
+				});
+
+				if (contained || (!parts.empty() && parts.size() <= cull_candidates && covers(parts, *bounds))) {
+					culled[n] = true;
+					stats.covered++;
+				}
+				else if (solid)
+					later.insert(*bounds); // a covered one adds nothing to what covers it
+			}
+		}
+
+		// front to back: a clear colored tile only hides what was drawn before it
+		if (clear.a == 255) {
+			band_index earlier;
+
+			for (size_t n = 0; n < items.size(); n++) {
+				if (culled[n])
+					continue;
+
+				const rect* bounds;
+
+				if (auto t = std::get_if<tile>(items[n])) {
+					bounds = &t->bounds;
+
+					if (t->color == clear) {
+						bool under = false;
+
+						earlier.query(*bounds, [&](const rect&) {
+							under = true;
+							return false;
+						});
+
+						if (!under) {
+							culled[n] = true;
+							stats.blank++;
+							continue;
+						}
+					}
+				}
+				else if (auto i = std::get_if<image>(items[n]))
+					bounds = &i->bounds;
+				else
+					continue;
+
+				earlier.insert(*bounds);
+			}
+		}
+
+		size_t kept = 0;
+		for (size_t n = 0; n < items.size(); n++)
+			if (!culled[n])
+				items[kept++] = items[n];
+
+		items.resize(kept);
+
+		return stats;
+	}
+};
\ No newline at end of file
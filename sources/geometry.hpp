@@ -0,0 +1,50 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// pre-render passes over a page's tiles; the parsed list is left as it is
+	namespace geometry {
+		struct merge_stats {
+			size_t before = 0; // B tiles
+			size_t after = 0;
+			uint64_t area_before = 0; // filled pixels, overlaps counted twice
+			uint64_t area_after = 0;
+		};
+
+		struct cull_stats {
+			size_t tiles = 0; // tiles and images looked at
+			size_t covered = 0; // painted over by later opaque tiles or images
+			size_t blank = 0; // opaque clear color over nothing
+		};
+
+		// the items of a tiles list, in draw order, that page::prepare turns into drawables
+		using draw_list = std::vector<const tiles::value_type*>;
+
+		// how far back, in drawn tiles, a B tile looks for one to merge into
+		static const size_t merge_window = 32;
+
+		// height of the horizontal bands culling buckets rects into
+		static const int32_t cull_band = 64;
+
+		// a rect covered by more partial occluders than this is kept rather than tested
+		static const size_t cull_candidates = 64;
+
+		// copies src into dest with adjacent or overlapping opaque B tiles of one color
+		// folded into the earlier one whenever their union is a rectangle and nothing
+		// drawn between them touches the later one, so the page paints the same pixels
+		merge_stats merge_tiles(const tiles& src, tiles& dest);
+
+		// drops from items the tiles and images whose pixels never reach the screen: those
+		// fully covered by the union of later opaque tiles and images, and opaque tiles of
+		// the clear color with nothing drawn under them. opaque tells whether an image
+		// tile paints every pixel of its bounds
+		cull_stats cull_tiles(draw_list& items, const sf::Color& clear, const std::function<bool(const image&)>& opaque);
+
+		// the union of two rects when it is a rect itself
+		bool merge(rect& a, const rect& b);
+
+		// whether the union of the parts rect r exactly
+		bool covers(const std::vector<rect>& parts, const rect& r);
+	};
+};
\ No newline at end of file
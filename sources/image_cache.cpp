@@ -0,0 +1,95 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	image_cache::image_cache() {
+	}
+
+	image_cache::~image_cache() {
+	}
+
+	image_cache& image_cache::shared() {
+		static image_cache _shared;
+		return _shared;
+	}
+
+	uint64_t image_cache::key(uint64_t hash, size_t len) {
+		// the length spreads hashes that differ little across the words
+		return hash ^ (static_cast<uint64_t>(len) * 0x9E3779B97F4A7C15ULL);
+	}
+
+	std::unordered_multimap<uint64_t, image_cache::slot>::iterator image_cache::match(uint64_t hash, std::string_view data, const sf::Vector2u& shown) {
+		auto range = _slots.equal_range(key(hash, data.size()));
+
+		for (auto i = range.first; i != range.second; ++i)
+			if (i->second.shown == shown && i->second.data == data)
+				return i;
+
+		return _slots.end();
+	}
+
+	image_cache::entry image_cache::find(uint64_t hash, std::string_view data, const sf::Vector2u& shown) {
+		std::lock_guard<std::mutex> lock(_lock);
+		_lookups++;
+
+		entry ret;
+
+		auto i = match(hash, data, shown);
+		if (i != _slots.end()) {
+			ret.texture = i->second.texture.lock();
+			ret.opaque = i->second.opaque;
+		}
+
+		if (ret.texture != nullptr)
+			_hits++;
+
+		return ret;
+	}
+
+	image_cache::entry image_cache::insert(uint64_t hash, std::string_view data, const sf::Vector2u& shown, const entry& decoded) {
+		std::lock_guard<std::mutex> lock(_lock);
+
+		auto i = match(hash, data, shown);
+		if (i == _slots.end())
+			i = _slots.emplace(key(hash, data.size()), slot{ std::string(data), shown, {}, false });
+
+		slot& s = i->second;
+
+		entry ret{ s.texture.lock(), s.opaque };
+		if (ret.texture == nullptr) {
+			s.texture = decoded.texture;
+			s.opaque = decoded.opaque;
+			ret = decoded;
+		}
+
+		// amortized: the table is swept each time it doubles
+		if (_slots.size() >= _sweep_at) {
+			for (auto j = _slots.begin(); j != _slots.end();) {
+				if (j->second.texture.expired())
+					j = _slots.erase(j);
+				else
+					++j;
+			}
+
+			_sweep_at = std::max<size_t>(64, _slots.size() * 2);
+		}
+
+		return ret;
+	}
+
+	image_cache::stats image_cache::get_stats() {
+		std::lock_guard<std::mutex> lock(_lock);
+
+		stats ret;
+		ret.lookups = _lookups;
+		ret.hits = _hits;
+
+		for (const auto& i : _slots) {
+			if (auto texture = i.second.texture.lock()) {
+				ret.live++;
+				ret.bytes += static_cast<size_t>(texture->getSize().x) * texture->getSize().y * 4 * 4 / 3;
+			}
+		}
+
+		return ret;
+	}
+};
\ No newline at end of file
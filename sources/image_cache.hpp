@@ -0,0 +1,59 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// decoded images by their encoded bytes and the size they were decoded at, shared by
+	// every address and page showing them; the content hash only finds the candidates,
+	// a copy of the bytes confirms a hit. Only weak references to the textures are kept,
+	// one is released with the last page using it
+	class image_cache : private sf::NonCopyable {
+	public:
+		struct entry {
+			sptr_t<sf::Texture> texture;
+			bool opaque = false; // every decoded pixel has full alpha
+		};
+
+		struct stats {
+			size_t lookups = 0;
+			size_t hits = 0;
+			size_t live = 0;	// textures still used by some page
+			size_t bytes = 0;	// of those, mip levels included
+		};
+
+		image_cache();
+		~image_cache();
+
+		// the one serving all pages of the process
+		static image_cache& shared();
+
+		// hash: cache::hash of data; texture is null on a miss
+		entry find(uint64_t hash, std::string_view data, const sf::Vector2u& shown);
+
+		// returns the entry already cached when another page decoded the same image meanwhile
+		entry insert(uint64_t hash, std::string_view data, const sf::Vector2u& shown, const entry& decoded);
+
+		stats get_stats();
+
+	private:
+		struct slot {
+			std::string data; // encoded
+			sf::Vector2u shown;
+
+			std::weak_ptr<sf::Texture> texture;
+			bool opaque;
+		};
+
+		std::mutex _lock;
+		std::unordered_multimap<uint64_t, slot> _slots;
+
+		size_t _lookups = 0;
+		size_t _hits = 0;
+		size_t _sweep_at = 64; // expired slots are dropped when the table grows past this
+
+		static uint64_t key(uint64_t hash, size_t len);
+
+		// the slot for exactly these bytes at this size, live or not
+		std::unordered_multimap<uint64_t, slot>::iterator match(uint64_t hash, std::string_view data, const sf::Vector2u& shown);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	const std::string& istring::empty_string() {
+		static const std::string empty;
+		return empty;
+	}
+
+	std::ostream& operator<<(std::ostream& out, const istring& s) {
+		return out << s.str();
+	}
+
+	interner::interner() {
+	}
+
+	interner::~interner() {
+	}
+
+	istring interner::intern(std::string_view s) {
+		if (s.empty())
+			return istring();
+
+		std::lock_guard<std::mutex> lock(_lock);
+
+		auto i = _index.find(s);
+		if (i != _index.end()) {
+			_saved += s.size();
+			return istring(i->second);
+		}
+
+		_strings.emplace_back(s);
+		const std::string* stored = &_strings.back();
+
+		_index.emplace(*stored, stored);
+		_bytes += s.size();
+
+		return istring(stored);
+	}
+
+	size_t interner::get_count() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _strings.size();
+	}
+
+	size_t interner::get_bytes() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _bytes;
+	}
+
+	size_t interner::get_saved() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _saved;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// handle to a string owned by an interner: copies are pointer copies and
+	// strings from the same interner compare by identity
+	class istring {
+	public:
+		istring() : _s(&empty_string()) {
+		}
+
+		const std::string& str() const { return *_s; }
+		operator const std::string&() const { return *_s; }
+		operator std::string_view() const { return *_s; }
+
+		const char* c_str() const { return _s->c_str(); }
+		size_t size() const { return _s->size(); }
+		bool empty() const { return _s->empty(); }
+
+		std::string::const_iterator begin() const { return _s->begin(); }
+		std::string::const_iterator end() const { return _s->end(); }
+
+		// by id, not by content: only meaningful within one interner
+		bool operator==(const istring& o) const { return _s == o._s; }
+		bool operator!=(const istring& o) const { return _s != o._s; }
+		bool operator<(const istring& o) const { return _s < o._s; }
+
+		uintptr_t id() const { return reinterpret_cast<uintptr_t>(_s); }
+
+		struct hash {
+			size_t operator()(const istring& s) const { return std::hash<uintptr_t>()(s.id()); }
+		};
+
+		static const std::string& empty_string();
+
+	private:
+		friend class interner;
+
+		explicit istring(const std::string* s) : _s(s) {
+		}
+
+		const std::string* _s;
+	};
+
+	std::ostream& operator<<(std::ostream& out, const istring& s);
+
+	// string table for one page, or shared by many; safe to use from several threads
+	class interner : private sf::NonCopyable {
+	public:
+		interner();
+		~interner();
+
+		istring intern(std::string_view s);
+
+		size_t get_count();		// unique strings
+		size_t get_bytes();		// stored
+		size_t get_saved();		// not stored again thanks to repeats
+
+	private:
+		std::mutex _lock;
+
+		std::deque<std::string> _strings; // element addresses are stable
+		std::unordered_map<std::string_view, const std::string*> _index;
+
+		size_t _bytes = 0;
+		size_t _saved = 0;
+	};
+};
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	namespace json {
+		std::string escape(const std::string& s) {
+			std::string ret;
+			ret.reserve(s.size());
+
+			for (char c : s) {
+				switch (c) {
+				case '"': ret += "\\\""; break;
+				case '\\': ret += "\\\\"; break;
+				case '\n': ret += "\\n"; break;
+				case '\r': ret += "\\r"; break;
+				case '\t': ret += "\\t"; break;
+				default:
+					if (static_cast<uint8_t>(c) < 0x20) {
+						char buf[8];
+						snprintf(buf, sizeof buf, "\\u%04x", c);
+						ret += buf;
+					}
+					else
+						ret += c;
+				}
+			}
+
+			return ret;
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// helpers for the line-oriented JSON the headless tools write
+	namespace json {
+		std::string escape(const std::string& s);
+	};
+};
\ No newline at end of file
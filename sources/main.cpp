@@ -17,7 +17,7 @@ static const uint32_t height = width / 16*9;
 		int main()
 	#endif
 #else
-	int main()
+	int main(int argc, char* argv[])
 #endif
 {
 #if defined _WIN32
@@ -30,11 +30,24 @@ static const uint32_t height = width / 16*9;
 #ifdef __NoConsole__
 	std::fstream log("log.txt", std::ios::trunc);
 	std::cout.set_rdbuf(log.rdbuf());
+	std::cerr.set_rdbuf(log.rdbuf());
 	sf::err().set_rdbuf(log.rdbuf());
 #endif
 
+#ifndef __NoConsole__
+	cli _cli(argc, argv);
+	if (_cli.has_command())
+		return _cli.run();
+#endif
+
+	// OBML_TRACE=<file.json> records parse/render stages as Chrome trace events
+	if (const char* trace_path = std::getenv("OBML_TRACE"))
+		trace::start(trace_path);
+
 	viewer _viewer({ width, height });
 	_viewer.open();
 
+	trace::stop();
+
 	return 0;
 }
\ No newline at end of file
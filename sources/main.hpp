@@ -1,12 +1,30 @@
 #pragma once
 
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cmath>
+#include <limits>
 #include <variant>
+#include <string_view>
+#include <array>
+#include <random>
+#include <functional>
+#include <set>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <SFML\Graphics.hpp>
 
@@ -14,12 +32,33 @@
 #include "imgui\imgui_internal.h"
 #include "imgui\imgui-SFML.h"
 
+#include "interner.hpp"
 #include "entity.hpp"
+#include "json.hpp"
+#include "uri.hpp"
+#include "tokenizer.hpp"
+#include "cache.hpp"
+#include "image_cache.hpp"
+#include "profiler.hpp"
+#include "geometry.hpp"
 #include "page.hpp"
 #include "reader.hpp"
+#include "scanner.hpp"
 #include "parser.hpp"
+#include "dump.hpp"
+#include "corpus_index.hpp"
+#include "writer.hpp"
+#include "generator.hpp"
+#include "search.hpp"
 #include "viewer.hpp"
+#include "bench.hpp"
+#include "pool.hpp"
+#include "service.hpp"
+#include "cli.hpp"
 
 #define __Debug__
 //#define __DebugVerbose__
-//#define __NoConsole__
\ No newline at end of file
+//#define __NoConsole__
+#define __Trace__
+
+#include "trace.hpp" // TRACE_SCOPE depends on the flags above
\ No newline at end of file
@@ -1,33 +1,127 @@
 #include "main.hpp"
 
 namespace obml_renderer {
-	page::page(const path& target) : _path(target) {
+	void render::fonts::warm(const charsets& sets, const std::map<int8_t, font_style>& sizes) const {
+		sf::Context context; // glyph pages are textures, so this thread needs its own context
+
+		for (const auto& i : sets) {
+			auto style = sizes.find(i.first);
+			if (style == sizes.end())
+				continue;
+
+			bool bold = (style->second.style & sf::Text::Style::Bold) != 0;
+
+			for (auto j : i.second)
+				font.getGlyph(j, style->second.size, bold);
+		}
+	}
+
+	pool& render::workers() {
+		static pool _workers;
+		return _workers;
+	}
+
+	page::page(const path& target, const sptr_t<interner>& strings) :
+		_strings(strings != nullptr ? strings : std::make_shared<interner>()),
+		_path(target)
+	{
 		load(target);
 	}
 
+	page::page(const sptr_t<const blob>& source, const path& name, const sptr_t<interner>& strings) :
+		_strings(strings != nullptr ? strings : std::make_shared<interner>()),
+		_path(name)
+	{
+		load(source);
+	}
+
 	page::~page() {
 		cleanup();
 	}
 
 	void page::load(const path& target) {
 		cleanup();
+		_profiler.clear();
+
+		_path = target;
+
+		{
+			profiler::scope _scope(_profiler, "read");
+			_source = reader::load(target);
+		}
+
+		parse();
+	}
+
+	void page::load(const sptr_t<const blob>& source) {
+		cleanup();
+		_profiler.clear();
 
+		_source = source;
+		parse();
+	}
+
+	void page::parse() {
 		parser _parser(*this);
 		_err = _parser.parse();
 	}
 
 	void page::cleanup() {
+		wait_glyphs();
+
 		_tiles.clear();
 		_links.clear();
 		_images.clear();
+		_charsets.clear();
+
+		// a private table starts over, a shared one keeps serving the other pages
+		if (_strings.use_count() == 1)
+			_strings = std::make_shared<interner>();
 
-		_data.texts.clear();
-		_data.tiles.clear();
+		release();
+
+		_merged.clear();
+		_merge_stats = {};
+		_cull_stats = {};
 	}
 
 	void page::prepare() {
-		_data.tiles.clear();
-		_data.texts.clear();
+		profiler::scope _scope(_profiler, "prepare");
+		TRACE_SCOPE("page::prepare");
+
+		wait_glyphs();
+		release();
+
+		const tiles* source = &_tiles;
+		_merged.clear();
+		_merge_stats = {};
+
+		if (_merge_tiles) {
+			profiler::scope _merge(_profiler, "merge");
+			_merge_stats = geometry::merge_tiles(_tiles, _merged);
+			source = &_merged;
+		}
+
+		geometry::draw_list& draw = _data.items;
+
+		{
+			profiler::scope _cull(_profiler, "cull");
+
+			draw.reserve(source->size());
+			for (const auto& i : *source)
+				draw.push_back(&i);
+
+			// render() clears to white, so white tiles over nothing are skipped too
+			_cull_stats = geometry::cull_tiles(draw, sf::Color::White, [this](const image& i) {
+				if (i.slot == image::no_slot || _images[i.slot].texture == nullptr)
+					return i.color.a == 255; // drawn as a plain fill
+				return _images[i.slot].opaque;
+			});
+		}
+
+		// rasterize the page's character set while the drawables are built;
+		// sf::Text only touches the font when its geometry is first needed
+		_glyphs = std::async(std::launch::async, &page::warm_glyphs, this, _data._fonts->font_sizes);
 
 #if defined __Debug__
 		std::cout << "  --- links[" << _links.size() << "] ---" << std::endl;
@@ -48,8 +142,8 @@ namespace obml_renderer {
 #ifdef __DebugVerbose__
 		for (const auto& i : _images) {
 			std::cout
-				<< "    addr: " << std::hex << i.first << std::dec << std::endl
-				<< "    size: " << i.second->getSize().x << "x" << i.second->getSize().y << std::endl
+				<< "    addr: " << std::hex << i.addr << std::dec << std::endl
+				<< "    size: " << i.texture->getSize().x << "x" << i.texture->getSize().y << std::endl
 				<< std::endl
 			;
 		}
@@ -57,110 +151,265 @@ namespace obml_renderer {
 #endif
 
 #if defined __Debug__
-		std::cout << "  --- tiles[" << _tiles.size() << "] ---" << std::endl;
+		std::cout << "  --- tiles[" << draw.size() << "] ---" << std::endl;
 #endif
-		for (auto i : _tiles) {
-			if (std::holds_alternative<tile>(i)) {
-				const tile& t = std::get<tile>(i);
 
-				sf::RectangleShape rect{{ t.bounds.width, t.bounds.height }};
+		// drawables are built a band at a time, by the first render() that needs them
+		size_t count = std::max<size_t>(1, (std::max(0, _header.size.y) + render::chunk_height - 1) / render::chunk_height);
+		_data.chunks.resize(count);
 
-				rect.setPosition(t.bounds.left, t.bounds.top);
-				rect.setFillColor(t.color);
+		for (uint32_t n = 0; n < draw.size(); n++) {
+			const auto& i = *draw[n];
 
-				_data.tiles.push_back(rect);
-
-#ifdef __DebugVerbose__
-				std::cout
-					<< "    type: TILE" << std::endl
-					<< "    position: " << t.bounds.left << "x" << t.bounds.top << std::endl
-					<< "    size: " << t.bounds.width << "x" << t.bounds.height << std::endl
-					<< "    color: " << std::hex << t.color.toInteger() << std::dec << std::endl
-					<< std::endl
-					;
+#if defined __DebugVerbose__
+			print_item(i);
 #endif
+			if (std::holds_alternative<form>(i))
+				continue; // not drawn
+
+			const rect& b = std::visit([](const auto& j) -> const rect& { return j.bounds; }, i);
+			size_t first = band(static_cast<float>(b.top));
+
+			// a text belongs to the band it starts in, its glyphs are never clipped
+			if (std::holds_alternative<text>(i)) {
+				_data.chunks[first].texts.push_back(n);
+				continue;
 			}
-			else if (std::holds_alternative<image>(i)) {
-				const image& j = std::get<image>(i);
 
-				sf::RectangleShape rect{ { j.bounds.width, j.bounds.height } };
-				rect.setPosition(j.bounds.left, j.bounds.top);
-#if defined __DebugVerbose__
-				std::cout
-					<< "    type: IMAGE" << std::endl
-					<< "    position: " << j.bounds.left << "x" << j.bounds.top << std::endl
-					<< "    size: " << j.bounds.width << "x" << j.bounds.width << std::endl
-					<< "    color: " << std::hex << j.color.toInteger() << std::dec << std::endl
-					<< "    addr: " << std::hex << j.addr << std::dec
-					;
-#endif
+			size_t last = std::max(first, band(static_cast<float>(b.bottom() - 1)));
 
-				auto ik = _images.find(j.addr);
-				if (ik == _images.end()) {
-					rect.setFillColor(j.color);
-#if defined __DebugVerbose__
-					std::cout << " (!)";
-#endif
-				}
-				else {
-					if (ik->second == nullptr)
-						rect.setFillColor(j.color);
-					else
-						rect.setTexture(ik->second.get());
-				}
+			for (size_t c = first; c <= last; c++)
+				_data.chunks[c].items.push_back(n);
+		}
 
-#if defined __DebugVerbose__
-				std::cout << std::endl << std::endl;
-#endif
-				_data.tiles.push_back(rect);
+		_data.applied = _data._fonts->font_sizes;
+	}
+
+	void page::prepare(float top, float bottom) {
+		if (_data.chunks.empty())
+			return;
+
+		std::vector<size_t> pending;
+
+		// what is on screen has to be there this frame, with the band above: its texts can reach down into view
+		size_t first = band(top);
+
+		for (size_t c = first > 0 ? first - 1 : first, last = band(bottom); c <= last; c++)
+			if (!_data.chunks[c].ready)
+				pending.push_back(c);
+
+		// one band of the margin per call keeps frames even while scrolling
+		for (size_t c = band(top - render::prefetch_margin), last = band(bottom + render::prefetch_margin); c <= last; c++) {
+			if (!_data.chunks[c].ready && std::find(pending.begin(), pending.end(), c) == pending.end()) {
+				pending.push_back(c);
+				break;
 			}
-			else if (std::holds_alternative<text>(i)) {
-				const text& t = std::get<text>(i);
+		}
+
+		build_chunks(pending);
+
+		for (size_t c = 0; c < _data.chunks.size(); c++) {
+			float chunk_top = static_cast<float>(c * render::chunk_height);
 
-				sf::Text text{
-					sf::String::fromUtf8(t.data.begin(), t.data.end()),
-					_data._fonts->font,
-					_data._fonts->font_sizes[t.font].size
-				};
+			if (chunk_top + render::chunk_height < top - render::evict_margin || chunk_top > bottom + render::evict_margin)
+				release_chunk(c);
+		}
+	}
 
-				text.setFillColor(t.color);
-				text.setPosition(t.bounds.left, t.bounds.top);
-				text.setStyle(_data._fonts->font_sizes[t.font].style);
+	size_t page::band(float y) const {
+		size_t last = _data.chunks.empty() ? 0 : _data.chunks.size() - 1;
+		return std::min(static_cast<size_t>(std::max(0.f, y) / render::chunk_height), last);
+	}
 
-				_data.texts.push_back(text);
+	void page::build_chunks(const std::vector<size_t>& bands) {
+		if (bands.empty())
+			return;
 
-#if defined __DebugVerbose__
-				std::cout
-					<< "    type: TEXT" << std::endl
-					<< "    position: " << t.bounds.left << "x" << t.bounds.top << std::endl
-					<< "    size: " << t.bounds.width << "x" << t.bounds.height << std::endl
-					<< "    color: " << std::hex << t.color.toInteger() << std::dec << std::endl
-					<< "    font: " << static_cast<int>(t.font) << std::endl
-					<< "    text: " << t.data << std::endl << std::endl
-					;
-#endif
+		profiler::scope _scope(_profiler, "geometry");
+
+		// bands only read the page and write their own chunk, so they build side by side
+		if (bands.size() == 1)
+			build_chunk(bands.front());
+		else {
+			std::vector<std::future<void>> jobs;
+
+			for (size_t c : bands)
+				jobs.push_back(render::workers().submit([this, c] { build_chunk(c); }));
+
+			for (auto& i : jobs)
+				i.get();
+		}
+
+		for (size_t c : bands)
+			_data.chunks[c].ready = true;
+	}
+
+	void page::build_chunk(size_t c) {
+		TRACE_SCOPE("page::build_chunk");
+
+		render::chunk& chunk = _data.chunks[c];
+
+		// rects are clipped to the band so neighbours can be drawn one after the other;
+		// the first and last bands are open towards the edges of the page
+		float band_top = c == 0 ? -FLT_MAX : static_cast<float>(c * render::chunk_height);
+		float band_bottom = c + 1 == _data.chunks.size() ? FLT_MAX : static_cast<float>((c + 1) * render::chunk_height);
+
+		chunk.batches.clear();
+
+		for (uint32_t n : chunk.items) {
+			const auto& i = *_data.items[n];
+
+			sf::FloatRect b;
+			sf::Color color;
+			const sf::Texture* texture = nullptr;
+
+			if (auto t = std::get_if<tile>(&i)) {
+				b = t->bounds.to_float();
+				color = t->color;
 			}
-			else if (std::holds_alternative<form>(i)) {
-				form& f = std::get<form>(i);
-#if defined __DebugVerbose__
-				std::cout
-					<< "    type: FORM" << std::endl
-					<< "    position: " << f.bounds.left << "x" << f.bounds.top << std::endl
-					<< "    size: " << f.bounds.width << "x" << f.bounds.height << std::endl
-					<< "    color: " << std::hex << f.color.toInteger() << std::dec << std::endl
-					<< "    type: " << f.type << std::endl
-					<< "    id: " << f.id << std::endl
-					<< "    value: " << f.value << std::endl << std::endl << std::endl
-					;
-#endif
+			else {
+				const image& j = std::get<image>(i);
+				b = j.bounds.to_float();
+				color = j.color;
+
+				if (j.slot != image::no_slot && _images[j.slot].texture != nullptr) {
+					texture = _images[j.slot].texture.get();
+					color = sf::Color::White;
+				}
+			}
+
+			float top = std::max(b.top, band_top);
+			float bottom = std::min(b.top + b.height, band_bottom);
+
+			if (bottom <= top)
+				continue;
+
+			// consecutive quads with the same texture are one draw call
+			if (chunk.batches.empty() || chunk.batches.back().texture != texture)
+				chunk.batches.push_back({ texture, sf::VertexArray(sf::Quads) });
+
+			sf::VertexArray& quads = chunk.batches.back().vertices;
+
+			float u = 0.f, v0 = 0.f, v1 = 0.f;
+			if (texture != nullptr) {
+				sf::Vector2f size{ texture->getSize() };
+
+				u = size.x;
+				v0 = (top - b.top) / b.height * size.y;
+				v1 = (bottom - b.top) / b.height * size.y;
 			}
+
+			quads.append({ { b.left, top }, color, { 0.f, v0 } });
+			quads.append({ { b.left + b.width, top }, color, { u, v0 } });
+			quads.append({ { b.left + b.width, bottom }, color, { u, v1 } });
+			quads.append({ { b.left, bottom }, color, { 0.f, v1 } });
+		}
+
+		chunk.runs.clear();
+		chunk.runs.reserve(chunk.texts.size());
+
+		// glyph geometry is left to the render thread, sf::Font is not safe to share
+		for (uint32_t n : chunk.texts) {
+			const text& t = std::get<text>(*_data.items[n]);
+
+			auto style = _data._fonts->font_sizes.find(t.font);
+			render::font_style s = style != _data._fonts->font_sizes.end() ? style->second : render::font_style{ 0, sf::Text::Style::Regular };
+
+			sf::Text text{
+				sf::String::fromUtf8(t.data.begin(), t.data.end()),
+				_data._fonts->font,
+				s.size
+			};
+
+			text.setFillColor(t.color);
+			text.setPosition(static_cast<float>(t.bounds.left), static_cast<float>(t.bounds.top));
+			text.setStyle(s.style);
+
+			chunk.runs.push_back({ t.font, text });
+		}
+	}
+
+	void page::release_chunk(size_t c) {
+		render::chunk& chunk = _data.chunks[c];
+		if (!chunk.ready)
+			return;
+
+		std::vector<render::batch>().swap(chunk.batches);
+		std::vector<render::text_run>().swap(chunk.runs);
+
+		chunk.ready = false;
+	}
+
+	void page::release() {
+		_data.items.clear();
+		_data.chunks.clear();
+		_data.drawn.clear();
+
+		for (auto& i : _data.lods)
+			i.clear();
+	}
+
+	void page::print_item(const tiles::value_type& i) const {
+		if (std::holds_alternative<tile>(i)) {
+			const tile& t = std::get<tile>(i);
+
+			std::cout
+				<< "    type: TILE" << std::endl
+				<< "    position: " << t.bounds.left << "x" << t.bounds.top << std::endl
+				<< "    size: " << t.bounds.width << "x" << t.bounds.height << std::endl
+				<< "    color: " << std::hex << t.color.toInteger() << std::dec << std::endl
+				<< std::endl
+				;
+		}
+		else if (std::holds_alternative<image>(i)) {
+			const image& j = std::get<image>(i);
+
+			std::cout
+				<< "    type: IMAGE" << std::endl
+				<< "    position: " << j.bounds.left << "x" << j.bounds.top << std::endl
+				<< "    size: " << j.bounds.width << "x" << j.bounds.width << std::endl
+				<< "    color: " << std::hex << j.color.toInteger() << std::dec << std::endl
+				<< "    addr: " << std::hex << j.addr << std::dec
+				;
+
+			if (j.slot == image::no_slot)
+				std::cout << " (!)";
+
+			std::cout << std::endl << std::endl;
+		}
+		else if (std::holds_alternative<text>(i)) {
+			const text& t = std::get<text>(i);
+
+			std::cout
+				<< "    type: TEXT" << std::endl
+				<< "    position: " << t.bounds.left << "x" << t.bounds.top << std::endl
+				<< "    size: " << t.bounds.width << "x" << t.bounds.height << std::endl
+				<< "    color: " << std::hex << t.color.toInteger() << std::dec << std::endl
+				<< "    font: " << static_cast<int>(t.font) << std::endl
+				<< "    text: " << t.data << std::endl << std::endl
+				;
+		}
+		else if (std::holds_alternative<form>(i)) {
+			const form& f = std::get<form>(i);
+
+			std::cout
+				<< "    type: FORM" << std::endl
+				<< "    position: " << f.bounds.left << "x" << f.bounds.top << std::endl
+				<< "    size: " << f.bounds.width << "x" << f.bounds.height << std::endl
+				<< "    color: " << std::hex << f.color.toInteger() << std::dec << std::endl
+				<< "    type: " << f.type << std::endl
+				<< "    id: " << f.id << std::endl
+				<< "    value: " << f.value << std::endl << std::endl << std::endl
+				;
 		}
-#if defined __Debug__
-		std::cout << "\n";
-#endif
 	}
 
 	void page::render() {
+		profiler::scope _scope(_profiler, "render");
+		TRACE_SCOPE("page::render");
+
+		wait_glyphs();
+
 		_data.rt.create(
 			_header.size.x,
 			std::min(
@@ -171,49 +420,262 @@ namespace obml_renderer {
 
 		_data.rt.clear(sf::Color::White);
 
-		for (auto i : _data.tiles)
-			_data.rt.draw(i);
-
-		for (auto i : _data.texts)
-			_data.rt.draw(i);
+		// exports need the whole page, so every band is built here
+		if (!_data.chunks.empty()) {
+			prepare(0.f, static_cast<float>(_header.size.y));
+			draw(_data.rt, 0, _data.chunks.size() - 1);
+		}
 
 		_data.rt.display();
 	}
 
 	void page::render(sf::RenderTarget& target) {
+		TRACE_SCOPE("page::render(target)");
+
+		// sf::Font is not safe to share: while prepare()'s warm still rasterizes the page's
+		// charset, texts go out as bars instead of holding the frame until it is done
+		bool glyphs = glyphs_ready();
+
 		target.clear(sf::Color::White);
 
-		for (auto i : _data.tiles)
-			target.draw(i);
+		if (_data.chunks.empty())
+			return;
+
+		const sf::View& view = target.getView();
+		float top = view.getCenter().y - view.getSize().y / 2.f;
+		float bottom = top + view.getSize().y;
+
+		// target pixels per page pixel
+		float scale = target.getViewport(view).height / view.getSize().y;
+
+		// spans are kept once drawn: until the glyphs are in, the level that draws texts
+		// is left to the bands, which draw bars
+		if (scale <= render::lod_scale && (glyphs || scale <= render::proxy_scale)) {
+			draw_lods(target, top, bottom, scale);
+			return;
+		}
+
+		prepare(top, bottom);
+		release_lods(top, bottom, render::evict_margin / scale);
+
+		draw(target, band(top), band(bottom), !glyphs);
+	}
+
+	void page::draw_lods(sf::RenderTarget& target, float top, float bottom, float scale) {
+		profiler::scope _scope(_profiler, "lod");
+
+		// the finest level still at least as sharp as the target
+		size_t level = static_cast<size_t>(std::min(static_cast<float>(render::lod_levels), std::max(1.f, std::log2(1.f / scale))));
+		auto& spans = _data.lods[level - 1];
+
+		float height = static_cast<float>(render::chunk_height << level);
+		spans.resize((_data.chunks.size() + (size_t(1) << level) - 1) >> level);
+
+		size_t first = std::min(static_cast<size_t>(std::max(0.f, top) / height), spans.size() - 1);
+		size_t last = std::min(static_cast<size_t>(std::max(0.f, bottom) / height), spans.size() - 1);
+
+		// unfinished spans share a budget of bands per frame, blank rows fill in over the next ones
+		size_t budget = render::lod_bands;
+
+		for (size_t s = first; s <= last; s++) {
+			build_lod(level, s, budget);
+
+			const render::lod* span = spans[s].get();
+			if (span == nullptr)
+				continue;
+
+			sf::Vector2u size = span->rt.getSize();
+			float span_top = s * height;
+			float span_height = std::min(static_cast<float>(_header.size.y), span_top + height) - span_top;
+
+			sf::Sprite sprite(span->rt.getTexture());
+			sprite.setPosition(0.f, span_top);
+			sprite.setScale(static_cast<float>(_header.size.x) / size.x, std::max(span_height, 1.f) / size.y);
+
+			target.draw(sprite);
+		}
+
+		release_lods(top, bottom, render::evict_margin / scale);
+	}
+
+	void page::build_lod(size_t level, size_t s, size_t& budget) {
+		uptr_t<render::lod>& span = _data.lods[level - 1][s];
+
+		size_t first = s << level;
+		size_t last = std::min(_data.chunks.size(), (s + 1) << level) - 1;
+
+		if (budget == 0 || (span != nullptr && span->done > last - first))
+			return;
+
+		float top = static_cast<float>(first * render::chunk_height);
+		float height = std::max(1.f, std::min(static_cast<float>(_header.size.y), static_cast<float>((last + 1) * render::chunk_height)) - top);
+		float width = static_cast<float>(std::max(1, _header.size.x));
+
+		if (span == nullptr) {
+			span = std::make_unique<render::lod>();
+
+			span->rt.create(
+				std::max(1u, static_cast<unsigned>(std::ceil(width / (1 << level)))),
+				std::max(1u, static_cast<unsigned>(std::ceil(height / (1 << level))))
+			);
+			span->rt.setSmooth(true);
+			span->rt.clear(sf::Color::White);
+		}
+
+		size_t from = first + span->done;
+		size_t to = std::min(last, from + budget - 1);
+
+		// the band above too: draw() takes the texts reaching into the step from it
+		std::vector<size_t> pending;
+		for (size_t c = from > 0 ? from - 1 : from; c <= to; c++)
+			if (!_data.chunks[c].ready)
+				pending.push_back(c);
+
+		build_chunks(pending);
+
+		// the viewport clips the step to its own rows: texts from the band above are
+		// drawn again over them, and ones reaching below are finished by the next step
+		float step_top = static_cast<float>(from * render::chunk_height);
+		float step_bottom = std::min(top + height, static_cast<float>((to + 1) * render::chunk_height));
+
+		sf::View view({ 0.f, step_top, width, step_bottom - step_top });
+		view.setViewport({ 0.f, (step_top - top) / height, 1.f, (step_bottom - step_top) / height });
+
+		span->rt.setView(view);
+		draw(span->rt, from, to, std::ldexp(1.f, -static_cast<int>(level)) <= render::proxy_scale);
+		span->rt.display();
+
+		// bands built only for this span are not kept
+		for (size_t c : pending)
+			release_chunk(c);
+
+		span->done += to - from + 1;
+		budget -= to - from + 1;
+	}
+
+	void page::release_lods(float top, float bottom, float margin) {
+		for (size_t level = 1; level <= render::lod_levels; level++) {
+			float height = static_cast<float>(render::chunk_height << level);
+			auto& spans = _data.lods[level - 1];
+
+			for (size_t s = 0; s < spans.size(); s++)
+				if (spans[s] != nullptr && ((s + 1) * height < top - margin || s * height > bottom + margin))
+					spans[s].reset();
+		}
+	}
+
+	void page::draw(sf::RenderTarget& target, size_t first, size_t last, bool proxies) {
+		for (size_t c = first; c <= last; c++)
+			for (const auto& i : _data.chunks[c].batches)
+				target.draw(i.vertices, i.texture);
+
+		// texts go over every tile, in page order; one starting a band up may reach into view
+		_data.drawn.clear();
+
+		for (size_t c = first > 0 ? first - 1 : first; c <= last; c++) {
+			const render::chunk& chunk = _data.chunks[c];
+
+			for (size_t i = 0; i < chunk.runs.size(); i++)
+				_data.drawn.push_back({ chunk.texts[i], &chunk.runs[i].text });
+		}
+
+		std::sort(_data.drawn.begin(), _data.drawn.end());
+
+		if (!proxies) {
+			for (const auto& i : _data.drawn)
+				target.draw(*i.second);
+
+			return;
+		}
+
+		// a bar over the middle of each run, about as dark as its glyphs would average out;
+		// the font is never touched
+		sf::VertexArray bars(sf::Quads);
 
-		for (auto i : _data.texts)
-			target.draw(i);
+		for (const auto& i : _data.drawn) {
+			const text& t = std::get<text>(*_data.items[i.first]);
+			const sf::FloatRect b = t.bounds.to_float();
+
+			sf::Color color = t.color;
+			color.a = color.a / 2;
+
+			bars.append({ { b.left, b.top + b.height / 4.f }, color });
+			bars.append({ { b.left + b.width, b.top + b.height / 4.f }, color });
+			bars.append({ { b.left + b.width, b.top + b.height * 3.f / 4.f }, color });
+			bars.append({ { b.left, b.top + b.height * 3.f / 4.f }, color });
+		}
+
+		target.draw(bars);
 	}
 
 	void page::update_fonts() {
-		_data.texts.clear();
+		wait_glyphs();
 
-		for(auto &i : _tiles) if (std::holds_alternative<text>(i)) {
-			const text& t = std::get<text>(i);
+		std::set<int8_t> changed;
 
-			sf::Text text{
-				sf::String::fromUtf8(t.data.begin(), t.data.end()),
-				_data._fonts->font,
-				_data._fonts->font_sizes[t.font].size
-			};
+		// only runs whose font_sizes entry differs from the applied layout are touched
+		for (const auto& i : _data._fonts->font_sizes) {
+			auto j = _data.applied.find(i.first);
 
-			text.setFillColor(t.color);
-			text.setPosition(t.bounds.left, t.bounds.top);
-			text.setStyle(_data._fonts->font_sizes[t.font].style);
+			if (j == _data.applied.end()
+				|| j->second.size != i.second.size
+				|| j->second.style != i.second.style)
+				changed.insert(i.first);
+		}
+
+		if (changed.empty())
+			return;
+
+		// zoomed out spans are drawn again with the new layout
+		for (auto& i : _data.lods)
+			i.clear();
+
+		// bands built later pick the new sizes up by themselves
+		for (auto& c : _data.chunks) for (auto& i : c.runs) if (changed.count(i.font)) {
+			const render::font_style& style = _data._fonts->font_sizes[i.font];
 
-			_data.texts.push_back(text);
+			i.text.setCharacterSize(style.size);
+			i.text.setStyle(style.style);
 		}
+
+		_data.applied = _data._fonts->font_sizes;
+	}
+
+	void page::warm_glyphs(const std::map<int8_t, render::font_style>& sizes) {
+		TRACE_SCOPE("page::warm_glyphs");
+
+		_data._fonts->warm(_charsets, sizes);
+	}
+
+	void page::wait_glyphs() {
+		if (_glyphs.valid())
+			_glyphs.get();
+	}
+
+	bool page::glyphs_ready() {
+		if (_glyphs.valid() && _glyphs.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		wait_glyphs();
+		return true;
 	}
 
 	void page::set_fonts(sptr_t<render::fonts>& fonts) {
 		_data._fonts = fonts;
 	}
 
+	void page::set_merge_tiles(bool enabled) {
+		_merge_tiles = enabled;
+	}
+
+	const geometry::merge_stats& page::get_merge_stats() const {
+		return _merge_stats;
+	}
+
+	const geometry::cull_stats& page::get_cull_stats() const {
+		return _cull_stats;
+	}
+
 	header& page::get_header() {
 		return _header;
 	}
@@ -230,10 +692,26 @@ namespace obml_renderer {
 		return _images;
 	}
 
+	charsets& page::get_charsets() {
+		return _charsets;
+	}
+
+	interner& page::get_strings() {
+		return *_strings;
+	}
+
+	profiler& page::get_profiler() {
+		return _profiler;
+	}
+
 	const path& page::get_path() const {
 		return _path;
 	}
 
+	const sptr_t<const blob>& page::get_source() const {
+		return _source;
+	}
+
 	int page::get_err() const {
 		return _err;
 	}
@@ -243,10 +721,12 @@ namespace obml_renderer {
 	}
 
 	bool page::export_page(const path& dest, const char* format) const {
+		TRACE_SCOPE("page::export_page");
+
 		sf::Image& image = _data.rt.getTexture().copyToImage();
 
 		std::stringstream ss;
-		ss << dest << _path.stem() << "." << format;
+		ss << dest.string() << _path.stem().u8string() << "." << format;
 
 #if defined __Debug__
 		std::cout << "Exporting page to '" << ss.str() << "'" << std::endl;
@@ -254,8 +734,10 @@ namespace obml_renderer {
 		return image.saveToFile(ss.str());
 	}
 
-	bool page::export_region(const path& dest, const sf::FloatRect& region, const char* format) const {
-		sf::IntRect r{ region };
+	bool page::export_region(const path& dest, const rect& region, const char* format) const {
+		TRACE_SCOPE("page::export_region");
+
+		sf::IntRect r{ region.left, region.top, region.width, region.height };
 
 		sf::Sprite t{ _data.rt.getTexture(), r };
 
@@ -285,15 +767,24 @@ namespace obml_renderer {
 	}
 
 	void page::export_images(const path& dest) const {
+		TRACE_SCOPE("page::export_images");
+
 		sf::Int32 count = 0;
-		std::stringstream fmt;
 
 		for (const auto& i : _images) {
-			fmt.clear();
-
-			fmt << dest << "File" << count++ << ".png";
-
-			i.second->copyToImage().saveToFile(fmt.str());
+			std::stringstream fmt;
+			fmt << dest.string() << "File" << count++ << ".png";
+
+			// textures may be downscaled to the size they are shown at, so decode the
+			// original again from the blob (addr is 3 bytes before its length)
+			reader r(_source, i.addr + 3);
+			auto data = r.read_view(static_cast<size_t>(std::max<int16_t>(r.read_short(), 0)));
+
+			sf::Image original;
+			if (r.good() && original.loadFromMemory(data.data(), data.size()))
+				original.saveToFile(fmt.str());
+			else if (i.texture != nullptr)
+				i.texture->copyToImage().saveToFile(fmt.str());
 		}
 	}
 }
\ No newline at end of file
@@ -4,8 +4,11 @@
 
 namespace obml_renderer {
 	class parser;
+	class pool;
 
 	namespace render {
+		static const char* default_font = "C:\\Windows\\Fonts\\ARIALUNI.ttf";
+
 		struct font_style {
 			uint32_t size;
 			uint8_t style;
@@ -20,44 +23,114 @@ namespace obml_renderer {
 				{ 5,{ 20, sf::Text::Style::Bold } },		// large bold
 				{ 6,{ 12, sf::Text::Style::Regular } }		// small
 			};
+
+			// rasterize code points into the glyph pages, from any thread
+			void warm(const charsets& sets, const std::map<int8_t, font_style>& sizes) const;
+		};
+
+		struct text_run {
+			int8_t font;
+			sf::Text text;
+		};
+
+		// drawables are built in horizontal bands of this height as the view nears them
+		static const int32_t chunk_height = 512;
+		// bands within this distance of the view are built ahead, one per frame
+		static const float prefetch_margin = 1024.f;
+		// bands further than this from the view are released
+		static const float evict_margin = 4096.f;
+
+		// zoomed out below this scale, the view is drawn from cached downscaled spans of bands
+		static const float lod_scale = 0.5f;
+		// below this scale texts are drawn as bars, their glyphs would be a few pixels tall
+		static const float proxy_scale = 0.25f;
+		// the coarsest level: spans of 2^lod_levels bands at 1/2^lod_levels of their size
+		static const size_t lod_levels = 8;
+		// bands drawn into unfinished spans per frame
+		static const size_t lod_bands = 8;
+
+		// quads sharing a texture, nullptr for plain fills
+		struct batch {
+			const sf::Texture* texture;
+			sf::VertexArray vertices;
+		};
+
+		struct chunk {
+			std::vector<uint32_t> items; // into data::items: tiles and images touching the band
+			std::vector<uint32_t> texts; // and texts starting in it
+
+			// while ready: items clipped to the band, and one run per entry of texts
+			std::vector<batch> batches;
+			std::vector<text_run> runs;
+			bool ready = false;
 		};
 
+		// 2^level bands at 1/2^level of their size, drawn a few bands per frame
+		struct lod {
+			sf::RenderTexture rt;
+			size_t done = 0; // bands drawn so far
+		};
+
+		// shared by every page to build bands
+		pool& workers();
+
 		struct data {
 			sf::RenderTexture rt;
 
-			std::list<sf::RectangleShape> tiles;
-			std::list<sf::Text> texts;
+			geometry::draw_list items; // merged and culled tiles, in draw order
+			std::vector<chunk> chunks;
+			std::array<std::vector<uptr_t<lod>>, lod_levels> lods; // by level - 1, then span
+
+			std::vector<std::pair<uint32_t, const sf::Text*>> drawn; // texts of the last frame, by item
 
 			sptr_t<fonts> _fonts;
+			std::map<int8_t, font_style> applied; // font_sizes the texts were laid out with
 		};
 	};
 
 	class page : private sf::NonCopyable {
 	public:
-		explicit page(const path& target);
+		// strings: an interner shared with other pages, by default the page has its own
+		explicit page(const path& target, const sptr_t<interner>& strings = nullptr);
+		page(const sptr_t<const blob>& source, const path& name, const sptr_t<interner>& strings = nullptr); // name only labels exports
 		~page();
 	
+		// indexes the drawables by band; they are built when a render needs them
 		void prepare();
+		// builds the bands between top and bottom, prefetches and evicts around them
+		void prepare(float top, float bottom);
+		// the whole page into the texture exports read
 		void render();
+		// what target's view shows, from downscaled spans when zoomed out
 		void render(sf::RenderTarget& target);
 
 		void load(const path& target);
+		void load(const sptr_t<const blob>& source);
 		void cleanup();
 
 		void update_fonts();
 		void set_fonts(sptr_t<render::fonts>& fonts);
 
+		// merge same-color B tiles before building the drawables, on the next prepare()
+		void set_merge_tiles(bool enabled);
+		const geometry::merge_stats& get_merge_stats() const;
+		const geometry::cull_stats& get_cull_stats() const;
+
 		header& get_header();
 		images& get_images();
 		tiles& get_tiles();
 		links& get_links();
+		charsets& get_charsets();
+		interner& get_strings();
+		profiler& get_profiler();
 
 		int get_err() const;
 		const path& get_path() const;
+		const sptr_t<const blob>& get_source() const;
 		const sf::Texture& get_texture() const;
 
 		bool export_page(const path& dest, const char* format = "png") const;
-		bool export_region(const path& dest, const sf::FloatRect& region, const char* format = "png") const;
+		bool export_region(const path& dest, const rect& region, const char* format = "png") const;
 		void export_images(const path& dest) const;
 
 	private:
@@ -65,10 +138,37 @@ namespace obml_renderer {
 		tiles _tiles;
 		links _links;
 		images _images;
+		charsets _charsets;
+		sptr_t<interner> _strings; // link types and hrefs, text runs
 
 		render::data _data;
+		std::future<void> _glyphs;
+
+		bool _merge_tiles = false;
+		tiles _merged; // _tiles after geometry::merge_tiles, while enabled
+		geometry::merge_stats _merge_stats;
+		geometry::cull_stats _cull_stats;
 
+		profiler _profiler; // load stage timings
+
+		sptr_t<const blob> _source; // the raw OBML bytes, shared with the parser's readers
 		path _path;
 		int _err;
+
+		void parse();
+
+		size_t band(float y) const;
+		void build_chunks(const std::vector<size_t>& bands);
+		void build_chunk(size_t c);
+		void release_chunk(size_t c);
+		void release();
+		void draw(sf::RenderTarget& target, size_t first, size_t last, bool proxies = false);
+		void draw_lods(sf::RenderTarget& target, float top, float bottom, float scale);
+		void build_lod(size_t level, size_t s, size_t& budget);
+		void release_lods(float top, float bottom, float margin);
+		void print_item(const tiles::value_type& i) const;
+		void warm_glyphs(const std::map<int8_t, render::font_style>& sizes);
+		void wait_glyphs();
+		bool glyphs_ready();
 	};
 };
\ No newline at end of file
@@ -9,282 +9,283 @@ namespace obml_renderer {
 
 	parser::err parser::parse() {
 		err _err = err::none;
-		_reader.open(_page.get_path());
+		_reader.open(_page.get_source());
 
-		if (!_reader.get_handle().is_open())
+		if (!_reader.is_open())
 			_err = err::bad_path;
 
-		if (_err == err::none)
-			_err = read_header();
+		profiler& _profiler = _page.get_profiler();
 
-		if (_err == err::none)
-			_err = read_metadata();
-
-		if (_err == err::none)
-			_err = read_links();
-
-		if (_err == err::none)
-			_err = read_content();
-
-		return _err;
-	}
+		if (_err == err::none) {
+			profiler::scope _scope(_profiler, "header");
+			_err = scanner::read_header(_reader, _page.get_header());
+		}
 
-	parser::err parser::read_header() {
-		header& _header = _page.get_header();
+		if (_err == err::none) {
+			profiler::scope _scope(_profiler, "metadata");
+			_err = scanner::read_metadata(_reader, _page.get_header(), _layout);
+		}
 
-		_header.data_len = _reader.read_medium() + 3;
-		_header.version = _reader.read_byte();
+		if (_err == err::none) {
+			// both sections are known after the metadata: links run on their own
+			// cursor over the shared buffer while this one continues into content
+			reader links_reader(_reader.get_data(), _layout.links_begin);
+			_reader.seek(_layout.links_end);
+
+			sf::Time links_time, content_time;
+
+			auto links = [&] {
+				sf::Clock clock;
+				err ret = scanner::read_links(links_reader, _layout, *this);
+				links_time = clock.getElapsedTime();
+				return ret;
+			};
+
+			auto content = [&] {
+				sf::Clock clock;
+				err ret = scanner::read_content(_reader, _layout, *this);
+				content_time = clock.getElapsedTime();
+				return ret;
+			};
+
+			err links_err, content_err;
+
+			if (_layout.links_end - _layout.links_begin >= concurrent_links_size) {
+				auto pending = std::async(std::launch::async, links);
+				content_err = content();
+				links_err = pending.get();
+			}
+			else {
+				links_err = links();
+				content_err = content();
+			}
 
-		if (_header.version != ver::v6) {
-			std::cout << "ERROR: OBML v" << (short)_header.version << " are not supported!" << std::endl;
+			// pushed from here, the profiler is not shared across threads
+			_profiler.push("links", links_time);
+			_profiler.push("content", content_time);
 
-			return err::version;
+			_err = links_err != err::none ? links_err : content_err;
 		}
 
-		_header.size = static_cast<sf::Vector2i>(_reader.read_coord());
+		if (_err == err::none && !_pending.empty()) {
+			profiler::scope _scope(_profiler, "images");
 
-		// skip S\x00\x00\xFF\xFF
-		_reader.skip(5);
+			// blobs arrive in file order, so addrs are sorted and each image tile finds
+			// its slot by binary search, once; the render path only indexes
+			auto by_addr = [](const encoded_image& i, uint32_t addr) { return i.addr < addr; };
 
-		_header.title = _reader.read_string();
+			// every image tile is known by now: nothing needs decoding larger than it is shown
+			for (auto& i : _page.get_tiles()) {
+				if (auto j = std::get_if<image>(&i)) {
+					auto k = std::lower_bound(_pending.begin(), _pending.end(), j->addr, by_addr);
+					if (k == _pending.end() || k->addr != j->addr)
+						continue;
 
-		// unknown: blob
-		_reader.skip_blob();
-		//_reader.dump_blob("header_unk.blob");
-		
-		_header.base_url = _reader.read_string();
-		_header.page_url = _reader.read_string();
+					j->slot = static_cast<uint32_t>(k - _pending.begin());
+					k->shown.x = std::max(k->shown.x, static_cast<unsigned>(std::max<int16_t>(j->bounds.width, 0)));
+					k->shown.y = std::max(k->shown.y, static_cast<unsigned>(std::max<int32_t>(j->bounds.height, 0)));
+				}
+			}
 
-		// metadata section
-		_reader.skip(1); // skip unknown: byte (always 19 or 23)
+			// one per content, shown as large as the largest of its addresses; the hash
+			// only narrows the candidates, the bytes decide
+			std::vector<encoded_image> distinct;
+			std::unordered_multimap<uint64_t, size_t> by_hash;
 
-		return err::none;
-	}
+			for (auto& i : _pending) {
+				auto range = by_hash.equal_range(i.hash);
+				auto k = std::find_if(range.first, range.second, [&](const std::pair<const uint64_t, size_t>& j) {
+					return distinct[j.second].data == i.data;
+				});
 
-	parser::err parser::read_metadata() {
-		while (_links_size == 0) {
-			switch (_reader.read_byte()) {
-			case 'M': {
-				switch (_reader.read_byte()) {
-				case 'C': // skip unknown: blob
-					_reader.dump_blob_alt("metadata_unk.blob");
-				//	_reader.skip_blob_alt();
-					break;
-
-				case 'u': // skip unknown: byte[7]
-					_reader.skip(7);
-					break;
-
-				case 'S': // skip tls information
-					_reader.skip_blob_alt();
-					break;
+				if (k == range.second) {
+					i.content = distinct.size();
+					by_hash.emplace(i.hash, i.content);
+					distinct.push_back(i);
+					continue;
 				}
+
+				i.content = k->second;
+
+				encoded_image& first = distinct[i.content];
+				first.shown.x = std::max(first.shown.x, i.shown.x);
+				first.shown.y = std::max(first.shown.y, i.shown.y);
 			}
-					  break;
 
-			case 'S': // links section
-				_links_size = _reader.read_medium();
-				break;
+			// only what no open page has decoded already
+			image_cache& _cache = image_cache::shared();
+			std::vector<encoded_image> missing;
+
+			for (auto& i : distinct) {
+				i.decoded = _cache.find(i.hash, i.data, i.shown);
+				if (i.decoded.texture == nullptr)
+					missing.push_back(i);
 			}
-		}
 
-		// links section
-		_links_begin = _reader.tell();
-		_links_end = _links_begin + _links_size;
+			decode_images(missing);
 
-//		std::cout << "links_start=" << _links_begin << ", links_end=" << _links_size << std::endl;
+			for (auto& i : missing)
+				distinct[i.content].decoded = _cache.insert(i.hash, i.data, i.shown, i.decoded);
 
-		return err::none;
-	}
+			images& _images = _page.get_images();
+			_images.reserve(_pending.size());
 
-	parser::err parser::read_links() {
-		links& _links = _page.get_links();
-
-		while (_reader.tell() < _links_end) {
-			int8_t type = _reader.read_byte();
-			switch (type) {
-			case '\0': { // data for drop-down lists (strings)
-				_reader.skip(1);
-				for (int8_t i = 0, len = _reader.read_byte(); i < len; i++) {
-					auto bytes = _reader.read_short();
-					_reader.skip(bytes);
-					_reader.skip_blob();
-				}
-			}
-					   break;
-
-			case 'i':
-			case 'w':
-			case 'W':
-			case 'L':
-			case 'P': {
-				int8_t count = _reader.read_byte();
-				if (count == 0)
-					_reader.skip(8);
-				else {
-					link l{};
-
-					for (int8_t i = 0; i < count; i++)
-						l.regions.push_back({ _reader.read_coord(), _reader.read_coord() });
-
-					l.target.type = _reader.read_string();
-					l.target.href = _reader.read_url();
-
-					_links.push_back(l);
-				}
+			for (const auto& i : _pending) {
+				const image_cache::entry& j = distinct[i.content].decoded;
+				_images.push_back({ i.addr, j.texture, j.opaque });
 			}
-					  break;
 
-			case 'C':// skip unknown: byte[21]
-				_reader.skip(21);
-				break;
+			_pending.clear();
+		}
 
-			case 'I': {
-				link l{};
-				for (int8_t i = 0, len = _reader.read_byte(); i < len; i++)
-					l.regions.push_back({ _reader.read_coord(), _reader.read_coord() });
+		return _err;
+	}
 
-				_reader.skip_blob();
-				_reader.skip(5);
+	void parser::on_link(const scanner::link_record& l) {
+		link _link{};
 
-				_links.push_back(l);
-			}
-					  break;
+		_link.regions.assign(l.regions.begin(), l.regions.end());
+		_link.target.type = _page.get_strings().intern(l.type);
+		_link.target.href = _page.get_strings().intern(l.href);
 
-			case 'N':
-			case 'S': {
-				link l{};
+		_page.get_links().push_back(_link);
+	}
 
-				for (int8_t i = 0, len = _reader.read_byte(); i < len; i++)
-					l.regions.push_back({ _reader.read_coord(), _reader.read_coord() });
+	void parser::on_tile(const tile& t) {
+		_page.get_tiles().push_back(t);
+	}
 
-				_reader.skip_blob(); // link_target: blob
-				_reader.skip_blob(); // link_target: blob
+	void parser::on_image(const image& i) {
+		_page.get_tiles().push_back(i);
+	}
 
-				_links.push_back(l);
-			}
-			break;
+	void parser::on_text(const scanner::text_record& t) {
+		text _text{};
 
-			default:
-				std::cout << "unknown link section at " << _reader.tell() << std::endl;
-				return err::bad_link_tag;
-			}
-		}
+		_text.bounds = t.bounds;
+		_text.color = t.color;
+		_text.font = t.font;
+		_text.data = _page.get_strings().intern(t.data);
 
-		if (_reader.tell() != _links_end) {
-			std::cout << "section ended at " << _reader.tell() << ", expected " << _links_end << std::endl;
-			return err::unknown;
+		// code points per font id, for glyph pre-warming
+		auto& charset = _page.get_charsets()[t.font];
+		for (auto i = t.data.begin(); i != t.data.end();) {
+			sf::Uint32 c = 0;
+			i = sf::Utf8::decode(i, t.data.end(), c);
+			charset.insert(c);
 		}
 
-		return err::none;
+		_page.get_tiles().push_back(_text);
 	}
 
-	parser::err parser::read_content() {
-		tiles& _tiles = _page.get_tiles();
-		images& _images = _page.get_images();
+	void parser::on_form(const scanner::form_record& f) {
+		form _form{};
 
-		size_t content_end = _page.get_header().data_len;
-//		std::cout << "content_start=" << _reader.tell() << ", content_end=" << content_end << std::endl;
+		_form.bounds = f.bounds;
+		_form.color = f.color;
+		_form.type = f.type;
+		_form.id = std::string(f.id);
+		_form.value = std::string(f.value);
 
-		while (_reader.tell() < content_end) {
-			int8_t type = _reader.read_byte();
+		_page.get_tiles().push_back(_form);
+	}
 
-			//std::cout << "[" << type << "]=" << _file.tell() << std::endl;
+	void parser::on_blob(const scanner::blob_record& b) {
+		encoded_image i{};
 
-			switch (type) {
-			case 'L':
-				_reader.skip(9);
-				break;
+		i.addr = b.addr;
+		i.data = b.data;
+		i.hash = cache::hash(b.data.data(), b.data.size());
 
-			case 'z':
-				_reader.skip(6);
-				break;
+		_pending.push_back(std::move(i));
+	}
 
-			case 'o':
-				_reader.skip_blob();
-				break;
+	void parser::decode_images(std::vector<encoded_image>& pending) {
+		TRACE_SCOPE("parser::decode_images");
 
-			case 'M': {
-				_reader.skip(2);
-				_reader.skip_blob();
-			}
-					  break;
-
-			case 'B': {
-				_tiles.push_back(tile{
-					{
-						_reader.read_coord(),
-						_reader.read_coord(),
-					},
-					_reader.read_color()
-				});
-			}
-					  break;
+		// decoding is CPU only and runs in parallel; GL uploads stay on this thread
+		size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), pending.size());
+		std::vector<std::future<void>> decoding;
 
-			case 'I': {
-				image i{};
+		for (size_t w = 0; w < workers; w++) {
+			decoding.push_back(std::async(std::launch::async, [&, w] {
+				TRACE_SCOPE("parser::decode_images(worker)");
 
-				i.bounds = { _reader.read_coord(), _reader.read_coord() };
-				i.color = _reader.read_color();
-				_reader.skip(3);
-				i.addr = _reader.read_medium();
+				for (size_t i = w; i < pending.size(); i += workers) {
+					encoded_image& j = pending[i];
 
-				_tiles.push_back(i);
-			}
-					  break;
+					if (!j.image.loadFromMemory(j.data.data(), j.data.size()))
+						continue;
+
+					sf::Vector2u size = j.image.getSize();
+					sf::Vector2u target{ std::min(size.x, j.shown.x), std::min(size.y, j.shown.y) };
 
-			case 'F': {
-				form f{};
+					if (target.x > 0 && target.y > 0 && target != size)
+						j.image = downscale(j.image, target);
 
-				f.bounds = { _reader.read_coord(), _reader.read_coord() };
-				f.color = _reader.read_color();
+					const sf::Uint8* pixels = j.image.getPixelsPtr();
+					size_t count = static_cast<size_t>(j.image.getSize().x) * j.image.getSize().y;
 
-				f.type = _reader.read_short();
-				f.id = _reader.read_string();
-				f.value = _reader.read_string();
+					j.decoded.opaque = count > 0;
+					for (size_t k = 0; k < count && j.decoded.opaque; k++)
+						j.decoded.opaque = pixels[k * 4 + 3] == 255;
+				}
+			}));
+		}
 
-				_reader.skip(3); // \xFF\xFF\xFF
+		for (auto& i : decoding)
+			i.get();
 
-				_tiles.push_back(f);
-			}
-					  break;
+		for (auto& i : pending) {
+			i.decoded.texture = std::make_shared<sf::Texture>();
+			i.decoded.texture->loadFromImage(i.image);
+			i.decoded.texture->generateMipmap(); // for views zoomed out below the shown size
+			i.image = sf::Image();
+		}
+	}
 
-			case 'T': {
-				text t{};
+	sf::Image parser::downscale(const sf::Image& source, const sf::Vector2u& size) {
+		const sf::Vector2u from = source.getSize();
+		const sf::Uint8* src = source.getPixelsPtr();
 
-				t.bounds = { _reader.read_coord(), _reader.read_coord() };
-				t.color = _reader.read_color();
-				t.font = _reader.read_byte();
-				t.data = _reader.read_string();
+		std::vector<sf::Uint8> dest(static_cast<size_t>(size.x) * size.y * 4);
 
-				_tiles.push_back(t);
-			}
-					  break;
+		for (size_t y = 0; y < size.y; y++) {
+			size_t y0 = y * from.y / size.y;
+			size_t y1 = std::max(y0 + 1, (y + 1) * from.y / size.y);
 
-			case 'S': {
-				size_t data_size = _reader.read_medium();
-				size_t data_begin = _reader.tell();
-				size_t data_end = data_begin + data_size;
+			for (size_t x = 0; x < size.x; x++) {
+				size_t x0 = x * from.x / size.x;
+				size_t x1 = std::max(x0 + 1, (x + 1) * from.x / size.x);
 
-				//std::cout << "data_size=" << data_size << std::endl;
+				uint64_t r = 0, g = 0, b = 0, a = 0;
 
-				while (_reader.tell() < data_end) {
-					auto addr = _reader.tell() - 3;
-					auto image = _reader.read_image();
+				for (size_t sy = y0; sy < y1; sy++) {
+					for (size_t sx = x0; sx < x1; sx++) {
+						const sf::Uint8* p = src + (sy * from.x + sx) * 4;
 
-					if (image != nullptr)
-						_images.insert({ addr, std::move(image) });
-					else
-						return err::bad_data;
+						r += p[0] * p[3];
+						g += p[1] * p[3];
+						b += p[2] * p[3];
+						a += p[3];
+					}
 				}
-			}
-			break;
 
-			default:
-				return err::bad_content_tag;
+				uint64_t n = (y1 - y0) * (x1 - x0);
+				sf::Uint8* d = &dest[(y * size.x + x) * 4];
+
+				d[3] = static_cast<sf::Uint8>((a + n / 2) / n);
+
+				if (a > 0) {
+					d[0] = static_cast<sf::Uint8>((r + a / 2) / a);
+					d[1] = static_cast<sf::Uint8>((g + a / 2) / a);
+					d[2] = static_cast<sf::Uint8>((b + a / 2) / a);
+				}
 			}
 		}
 
-		return err::none;
+		sf::Image ret;
+		ret.create(size.x, size.y, dest.data());
+		return ret;
 	}
 };
\ No newline at end of file
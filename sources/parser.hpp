@@ -3,21 +3,11 @@
 #include "main.hpp"
 
 namespace obml_renderer {
-	class parser : private sf::NonCopyable {
+	// materializes a scanned page into its lists and textures
+	class parser : private scanner::visitor, private sf::NonCopyable {
 	public:
-		enum ver {
-			v6 = 6
-		};
-
-		enum err {
-			none,
-			version,
-			bad_link_tag,
-			bad_content_tag,
-			bad_data,
-			bad_path,
-			unknown
-		};
+		using ver = scanner::ver;
+		using err = scanner::err;
 
 		explicit parser(page& p);
 		~parser();
@@ -25,16 +15,37 @@ namespace obml_renderer {
 		err parser::parse();
 
 	private:
+		// links sections smaller than this are not worth a thread
+		static const size_t concurrent_links_size = 4096;
+
+		struct encoded_image {
+			uint32_t addr;
+			std::string_view data;
+			uint64_t hash; // of data, blobs with the same bytes are decoded once
+			size_t content; // index of its bytes among the distinct ones
+
+			sf::Vector2u shown; // the largest bounds of the tiles showing it, 0x0 when none do
+
+			sf::Image image;
+			image_cache::entry decoded;
+		};
+
 		reader _reader;
 		page& _page;
 
-		sf::Int64 _links_begin;
-		sf::Int64 _links_end;
-		sf::Int64 _links_size;
+		scanner::layout _layout;
+		std::vector<encoded_image> _pending;
+
+		void on_link(const scanner::link_record& l) override;
+		void on_tile(const tile& t) override;
+		void on_image(const image& i) override;
+		void on_text(const scanner::text_record& t) override;
+		void on_form(const scanner::form_record& f) override;
+		void on_blob(const scanner::blob_record& b) override;
+
+		static void decode_images(std::vector<encoded_image>& pending);
 
-		err read_header();
-		err read_metadata();
-		err read_links();
-		err read_content();
+		// box filtered, weighting colors by alpha so transparent pixels do not bleed in
+		static sf::Image downscale(const sf::Image& source, const sf::Vector2u& size);
 	};
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	pool::pool(size_t threads) {
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+
+		for (size_t i = 0; i < threads; i++)
+			_threads.emplace_back(&pool::work, this);
+	}
+
+	pool::~pool() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_stop = true;
+		}
+
+		_wake.notify_all();
+
+		for (auto& i : _threads)
+			i.join();
+	}
+
+	size_t pool::size() const {
+		return _threads.size();
+	}
+
+	size_t pool::pending() {
+		std::lock_guard<std::mutex> lock(_lock);
+		return _jobs.size();
+	}
+
+	void pool::work() {
+		for (;;) {
+			std::function<void()> job;
+
+			{
+				std::unique_lock<std::mutex> lock(_lock);
+				_wake.wait(lock, [this] { return _stop || !_jobs.empty(); });
+
+				// drain what is queued before stopping
+				if (_jobs.empty())
+					return;
+
+				job = std::move(_jobs.front());
+				_jobs.pop_front();
+			}
+
+			job();
+		}
+	}
+};
\ No newline at end of file
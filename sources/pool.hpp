@@ -0,0 +1,41 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// fixed set of worker threads draining a FIFO of jobs
+	class pool : private sf::NonCopyable {
+	public:
+		explicit pool(size_t threads = 0); // 0 = hardware concurrency
+		~pool();
+
+		template<typename F>
+		auto submit(F&& job) -> std::future<decltype(job())> {
+			using result_t = decltype(job());
+
+			auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(job));
+			auto ret = task->get_future();
+
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				_jobs.emplace_back([task] { (*task)(); });
+			}
+
+			_wake.notify_one();
+			return ret;
+		}
+
+		size_t size() const;
+		size_t pending();
+
+	private:
+		std::vector<std::thread> _threads;
+		std::deque<std::function<void()>> _jobs;
+
+		std::mutex _lock;
+		std::condition_variable _wake;
+		bool _stop = false;
+
+		void work();
+	};
+};
\ No newline at end of file
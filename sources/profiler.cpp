@@ -0,0 +1,62 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	void profiler::stage::push(float ms) {
+		samples[offset] = ms;
+		offset = (offset + 1) % history;
+		count = std::min(count + 1, history);
+	}
+
+	float profiler::stage::last() const {
+		return count > 0 ? samples[(offset + history - 1) % history] : 0.f;
+	}
+
+	float profiler::stage::average() const {
+		if (count == 0)
+			return 0.f;
+
+		float sum = 0.f;
+		for (size_t i = 0; i < count; i++)
+			sum += samples[(offset + history - 1 - i) % history];
+
+		return sum / count;
+	}
+
+	float profiler::stage::peak() const {
+		return *std::max_element(samples.begin(), samples.end());
+	}
+
+	profiler::scope::scope(profiler& p, const char* name) : _profiler(p), _name(name) {
+	}
+
+	profiler::scope::~scope() {
+		_profiler.push(_name, _clock.getElapsedTime());
+	}
+
+	void profiler::push(const char* name, sf::Time time) {
+		// stages keep the order they were first pushed in
+		auto i = std::find_if(_stages.begin(), _stages.end(), [name](const stage& s) {
+			return s.name == name;
+		});
+
+		if (i == _stages.end()) {
+			_stages.push_back({ name });
+			i = _stages.end() - 1;
+		}
+
+		i->push(time.asMicroseconds() / 1000.f);
+	}
+
+	void profiler::merge(const profiler& other) {
+		for (const auto& i : other._stages) if (i.count > 0)
+			push(i.name.c_str(), sf::microseconds(static_cast<sf::Int64>(i.last() * 1000.f)));
+	}
+
+	void profiler::clear() {
+		_stages.clear();
+	}
+
+	const std::vector<profiler::stage>& profiler::get_stages() const {
+		return _stages;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	class profiler {
+	public:
+		static const size_t history = 120;
+
+		struct stage {
+			std::string name;
+			std::array<float, history> samples{}; // ms, ring buffer
+			size_t offset = 0;
+			size_t count = 0;
+
+			void push(float ms);
+			float last() const;
+			float average() const;
+			float peak() const;
+		};
+
+		class scope : private sf::NonCopyable {
+		public:
+			scope(profiler& p, const char* name);
+			~scope();
+
+		private:
+			profiler& _profiler;
+			const char* _name;
+			sf::Clock _clock;
+		};
+
+		void push(const char* name, sf::Time time);
+		void merge(const profiler& other);
+		void clear();
+
+		const std::vector<stage>& get_stages() const;
+
+	private:
+		std::vector<stage> _stages;
+	};
+};
\ No newline at end of file
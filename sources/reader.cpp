@@ -5,6 +5,10 @@ namespace obml_renderer {
 		open(_path);
 	}
 
+	reader::reader(const sptr_t<const blob>& data, size_t offset) {
+		open(data, offset);
+	}
+
 	reader::reader() {
 	}
 	
@@ -13,22 +17,50 @@ namespace obml_renderer {
 	}
 
 	void reader::open(const path& _path) {
-		_fh.open(_path, std::ios::in | std::ios::binary);
+		open(load(_path));
+	}
+
+	void reader::open(const sptr_t<const blob>& data, size_t offset) {
+		_data = data;
+		_pos = offset;
+		_good = _data != nullptr;
+	}
+
+	bool reader::is_open() {
+		return _data != nullptr;
 	}
 
 	void reader::close() {
-		_fh.close();
+		_data.reset();
+		_pos = 0;
+		_good = false;
+	}
+
+	void reader::read(char* dest, size_t len) {
+		size_t size = _data != nullptr ? _data->size() : 0;
+		size_t avail = _pos < size ? std::min(len, size - _pos) : 0;
+
+		if (avail > 0)
+			memcpy(dest, _data->data() + _pos, avail);
+
+		// past the end reads zeros, like a failed stream, and keeps moving
+		if (avail < len) {
+			memset(dest + avail, 0, len - avail);
+			_good = false;
+		}
+
+		_pos += len;
 	}
 
 	int8_t reader::read_byte() {
 		char buf;
-		_fh.read(&buf, sizeof buf);
+		read(&buf, sizeof buf);
 		return buf;
 	}
 
 	int16_t reader::read_short() {
 		char buf[2];
-		_fh.read(buf, 2);
+		read(buf, 2);
 		return static_cast<int16_t>(
 			((buf[0] & 0xFF) << 8) | (buf[1] & 0xFF)
 		);
@@ -36,22 +68,20 @@ namespace obml_renderer {
 
 	int32_t reader::read_medium() {
 		char buf[3];
-		_fh.read(buf, 3);
+		read(buf, 3);
 		return static_cast<int32_t>(
 			(buf[0] << 16) | (((buf[1] & 0xFF) << 8) | (buf[2] & 0xFF))
 		);
 	}
 
-	sf::Vector2f reader::read_coord() {
-		return {
-			static_cast<float>(read_short()),
-			static_cast<float>(read_medium())
-		};
+	sf::Vector2i reader::read_coord() {
+		int32_t x = read_short();
+		return { x, read_medium() };
 	}
 
 	sf::Color reader::read_color() {
 		uint8_t dest[4] = { 0, 0, 0, 0 };
-		_fh.read(reinterpret_cast<char*>(&dest), sizeof dest);
+		read(reinterpret_cast<char*>(&dest), sizeof dest);
 
 		return {
 			dest[1],
@@ -62,29 +92,40 @@ namespace obml_renderer {
 	}
 
 	std::string reader::read_url() {
+		return std::string(read_url_view());
+	}
+
+	std::string reader::read_string() {
+		return std::string(read_string_view());
+	}
+
+	std::string_view reader::read_url_view() {
 		auto len = read_short();
 
 		if (read_byte() != '\0')
-			_fh.seekg(-1, std::ios::cur);
+			_pos--;
 		else
 			len--;
 
-		std::string buf(len, 0);
-		_fh.read(&buf[0], len);
-
-		return buf;
+		return read_view(std::max<int16_t>(len, 0));
 	}
 
-	std::string reader::read_string() {
+	std::string_view reader::read_string_view() {
 		auto len = read_short();
-		std::string buf;
+		return read_view(std::max<int16_t>(len, 0));
+	}
 
-		if (len > 0) {
-			buf.resize(len);
-			_fh.read(&buf[0], len);
-		}
+	std::string_view reader::read_view(size_t len) {
+		size_t size = _data != nullptr ? _data->size() : 0;
+		size_t begin = std::min(_pos, size);
+		size_t avail = std::min(len, size - begin);
 
-		return buf;
+		if (avail < len)
+			_good = false;
+
+		_pos += len;
+
+		return { _data != nullptr ? _data->data() + begin : nullptr, avail };
 	}
 
 	uptr_t<blob> reader::read_blob() {
@@ -93,63 +134,114 @@ namespace obml_renderer {
 
 		if (len > 0) {
 			ret = std::make_unique<blob>(len + 1, 0);
-			_fh.read(reinterpret_cast<char*>(ret->data()), len);
+			read(reinterpret_cast<char*>(ret->data()), len);
 		}
 
 		return std::move(ret);
 	}
 
 	uptr_t<sf::Texture> reader::read_image() {
+		TRACE_SCOPE("reader::read_image");
+
 		auto len = read_short();
 		uptr_t<sf::Texture> ret = nullptr;
 
-		if (len > 0) {
-			auto buf = std::make_unique<char[]>(len);
-			if (_fh.read(buf.get(), len).good()) {
-				ret = std::make_unique<sf::Texture>();
-				ret->loadFromMemory(buf.get(), len);
-			}
+		if (len > 0 && _pos + len <= _data->size()) {
+			ret = std::make_unique<sf::Texture>();
+			ret->loadFromMemory(_data->data() + _pos, len);
 		}
 
+		skip(std::max<int16_t>(len, 0));
+
 		return std::move(ret);
 	}
 
 	void reader::dump(size_t bytes, const path& _path) {
 		blob buf(bytes);
-		_fh.read(&buf[0], bytes);
+		if (bytes > 0)
+			read(&buf[0], bytes);
 
 		std::ofstream _out(_path, std::ios::out | std::ios::trunc | std::ios::binary);
-		_out.write(&buf[0], buf.size());
+		_out.write(buf.data(), buf.size());
 		_out.close();
 	}
 
 	void reader::dump_blob(const path& _path) {
-		dump(read_short(), _path);
+		auto len = read_short();
+		if (len < 0)
+			_good = false;
+		else
+			dump(len, _path);
 	}
 
 	void reader::dump_blob_alt(const path& _path) {
-		dump(read_medium(), _path);
+		auto len = read_medium();
+		if (len < 0)
+			_good = false;
+		else
+			dump(len, _path);
 	}
 
 	size_t reader::tell() {
-		return static_cast<size_t>(_fh.tellg());
+		return _pos;
+	}
+
+	void reader::seek(size_t pos) {
+		_pos = pos;
+	}
+
+	bool reader::good() {
+		return _good;
 	}
 
 	size_t reader::skip(size_t bytes) {
-		return static_cast<size_t>(_fh.ignore(bytes).tellg());
+		// a length that wraps the cursor would move it backward, it stays put instead
+		if (_pos + bytes < _pos) {
+			_good = false;
+			return _pos;
+		}
+
+		_pos += bytes;
+
+		if (_data == nullptr || _pos > _data->size())
+			_good = false;
+
+		return _pos;
+	}
+
+	size_t reader::skip(int32_t bytes) {
+		// lengths are signed on disk; a negative one is broken data, never a step back
+		if (bytes < 0) {
+			_good = false;
+			return _pos;
+		}
+
+		return skip(static_cast<size_t>(bytes));
 	}
 
 	size_t reader::skip_blob() {
-		auto len = read_short();
-		return skip(len);
+		return skip(static_cast<int32_t>(read_short()));
 	}
 
 	size_t reader::skip_blob_alt() {
-		auto len = read_medium();
-		return skip(len);
+		return skip(read_medium());
+	}
+
+	const sptr_t<const blob>& reader::get_data() {
+		return _data;
 	}
 
-	std::fstream& reader::get_handle() {
-		return _fh;
+	sptr_t<const blob> reader::load(const path& _path, size_t limit) {
+		std::ifstream in(_path, std::ios::in | std::ios::binary | std::ios::ate);
+		if (!in.is_open())
+			return nullptr;
+
+		auto data = std::make_shared<blob>(std::min(static_cast<size_t>(in.tellg()), limit));
+		in.seekg(0);
+
+		if (!data->empty() && !in.read(data->data(), data->size()).good())
+			return nullptr;
+
+		return data;
 	}
 };
\ No newline at end of file
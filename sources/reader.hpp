@@ -3,13 +3,16 @@
 #include "main.hpp"
 
 namespace obml_renderer {
+	// cursor over an OBML buffer; several readers may share one buffer
 	class reader {
 	public:
 		reader(const path& _path);
+		reader(const sptr_t<const blob>& data, size_t offset = 0);
 		reader();
 		~reader();
 
 		void open(const path& _path);
+		void open(const sptr_t<const blob>& data, size_t offset = 0);
 		bool is_open();
 		void close();
 
@@ -17,12 +20,17 @@ namespace obml_renderer {
 		int16_t read_short();
 		int32_t read_medium();
 
-		sf::Vector2f read_coord();
+		sf::Vector2i read_coord();
 		sf::Color read_color();
 
 		std::string read_url();
 		std::string read_string();
 
+		// views into the buffer, valid while it is alive
+		std::string_view read_url_view();
+		std::string_view read_string_view();
+		std::string_view read_view(size_t len);
+
 		uptr_t<blob> read_blob();
 		uptr_t<sf::Texture> read_image();
 
@@ -31,14 +39,24 @@ namespace obml_renderer {
 		void dump_blob_alt(const path& _path);
 
 		size_t tell();
+		void seek(size_t pos);
+		bool good();
 
 		size_t skip(size_t bytes);
+		size_t skip(int32_t bytes); // a length field as read, negative fails without moving
 		size_t skip_blob();
 		size_t skip_blob_alt();
 
-		std::fstream& get_handle();
+		const sptr_t<const blob>& get_data();
+
+		// at most limit bytes from the start of the file
+		static sptr_t<const blob> load(const path& _path, size_t limit = SIZE_MAX);
 
 	private:
-		std::fstream _fh;
+		sptr_t<const blob> _data;
+		size_t _pos = 0;
+		bool _good = false;
+
+		void read(char* dest, size_t len);
 	};
 };
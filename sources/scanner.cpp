@@ -0,0 +1,392 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	scanner::scanner(const sptr_t<const blob>& data) : _data(data) {
+	}
+
+	scanner::~scanner() {
+	}
+
+	sptr_t<const blob> scanner::load(const path& _path, int sections) {
+		if (sections & (section::content | section::blobs))
+			return reader::load(_path);
+
+		auto data = reader::load(_path, prefix_size);
+		if (data == nullptr || data->size() < prefix_size)
+			return data;
+
+		reader r(data);
+		header h{};
+		layout l{};
+
+		if (read_header(r, h) != err::none || read_metadata(r, h, l) != err::none || !r.good())
+			return reader::load(_path); // metadata runs past the prefix, or is broken
+
+		size_t needed = (sections & section::links) ? l.links_end : l.links_begin;
+		return needed > data->size() ? reader::load(_path, needed) : data;
+	}
+
+	scanner::err scanner::probe(const path& _path, header& h) {
+		TRACE_SCOPE("scanner::probe");
+
+		auto data = reader::load(_path, header_size);
+		if (data == nullptr)
+			return err::bad_path;
+
+		reader r(data);
+		err _err = read_header(r, h);
+
+		// long titles or urls: lengths past the prefix read as zero, so the
+		// cursor is only a lower bound; grow until the header fits or the file ends
+		for (size_t limit = header_size; _err == err::none && !r.good() && data->size() == limit;) {
+			limit = std::max(r.tell(), limit * 2);
+
+			data = reader::load(_path, limit);
+			if (data == nullptr)
+				return err::bad_path;
+
+			r.open(data);
+			_err = read_header(r, h);
+		}
+
+		if (_err == err::none && !r.good())
+			return err::bad_data;
+
+		return _err;
+	}
+
+	scanner::err scanner::scan(visitor& v, int sections) {
+		reader r(_data);
+
+		if (!r.is_open())
+			return err::bad_path;
+
+		header h{};
+		layout l{};
+
+		err _err = read_header(r, h);
+		if (_err != err::none)
+			return _err;
+
+		_err = read_metadata(r, h, l);
+		if (_err != err::none)
+			return _err;
+
+		v.on_header(h);
+
+		if (sections & section::links) {
+			_err = read_links(r, l, v);
+			if (_err != err::none)
+				return _err;
+		}
+
+		if (sections & (section::content | section::blobs)) {
+			r.seek(l.links_end);
+			_err = read_content(r, l, v, (sections & section::blobs) != 0);
+		}
+
+		return _err;
+	}
+
+	scanner::err scanner::read_header(reader& r, header& h) {
+		TRACE_SCOPE("scanner::read_header");
+
+		// the 24-bit length is signed on disk, a negative one would end the content past 4G
+		int32_t data_len = r.read_medium();
+		if (data_len < 0)
+			return err::bad_data;
+
+		h.data_len = data_len + 3;
+		h.version = r.read_byte();
+
+		if (h.version != ver::v6) {
+			std::cerr << "ERROR: OBML v" << (short)h.version << " are not supported!" << std::endl;
+
+			return err::version;
+		}
+
+		h.size = r.read_coord();
+
+		// skip S\x00\x00\xFF\xFF
+		r.skip(5);
+
+		h.title = r.read_string();
+
+		// unknown: blob
+		r.skip_blob();
+		//r.dump_blob("header_unk.blob");
+
+		h.base_url = r.read_string();
+		h.page_url = r.read_string();
+
+		// metadata section
+		r.skip(1); // skip unknown: byte (always 19 or 23)
+
+		return err::none;
+	}
+
+	scanner::err scanner::read_metadata(reader& r, const header& h, layout& l) {
+		TRACE_SCOPE("scanner::read_metadata");
+
+		size_t content_end = h.data_len;
+		size_t links_size = 0;
+
+		for (bool done = false; !done;) {
+			if (r.tell() >= content_end || !r.good())
+				return err::bad_data;
+
+			switch (r.read_byte()) {
+			case 'M': {
+				switch (r.read_byte()) {
+				case 'C': // skip unknown: blob
+#if defined __DebugVerbose__
+					r.dump_blob_alt("metadata_unk.blob");
+#else
+					r.skip_blob_alt();
+#endif
+					break;
+
+				case 'u': // skip unknown: byte[7]
+					r.skip(7);
+					break;
+
+				case 'S': // skip tls information
+					r.skip_blob_alt();
+					break;
+				}
+			}
+					  break;
+
+			case 'S': { // links section
+				int32_t size = r.read_medium();
+				if (size < 0)
+					return err::bad_data;
+
+				links_size = size;
+				done = true;
+			}
+			break;
+			}
+		}
+
+		// links section
+		l.links_begin = r.tell();
+		l.links_end = l.links_begin + links_size;
+		l.content_end = content_end;
+
+//		std::cout << "links_start=" << l.links_begin << ", links_end=" << links_size << std::endl;
+
+		return err::none;
+	}
+
+	scanner::err scanner::read_links(reader& r, const layout& l, visitor& v) {
+		TRACE_SCOPE("scanner::read_links");
+
+		link_record rec{};
+
+		while (r.tell() < l.links_end) {
+			if (!r.good())
+				return err::bad_data;
+
+			rec.tag = r.read_byte();
+			rec.regions.clear();
+			rec.type = {};
+			rec.href = {};
+
+			switch (rec.tag) {
+			case '\0': { // data for drop-down lists (strings)
+				r.skip(1);
+				for (int8_t i = 0, len = r.read_byte(); i < len; i++) {
+					auto bytes = r.read_short();
+					r.skip(bytes);
+					r.skip_blob();
+				}
+			}
+					   break;
+
+			case 'i':
+			case 'w':
+			case 'W':
+			case 'L':
+			case 'P': {
+				int8_t count = r.read_byte();
+				if (count == 0)
+					r.skip(8);
+				else {
+					for (int8_t i = 0; i < count; i++)
+						rec.regions.push_back({ r.read_coord(), r.read_coord() });
+
+					rec.type = r.read_string_view();
+					rec.href = r.read_url_view();
+
+					v.on_link(rec);
+				}
+			}
+					  break;
+
+			case 'C':// skip unknown: byte[21]
+				r.skip(21);
+				break;
+
+			case 'I': {
+				for (int8_t i = 0, len = r.read_byte(); i < len; i++)
+					rec.regions.push_back({ r.read_coord(), r.read_coord() });
+
+				r.skip_blob();
+				r.skip(5);
+
+				v.on_link(rec);
+			}
+					  break;
+
+			case 'N':
+			case 'S': {
+				for (int8_t i = 0, len = r.read_byte(); i < len; i++)
+					rec.regions.push_back({ r.read_coord(), r.read_coord() });
+
+				r.skip_blob(); // link_target: blob
+				r.skip_blob(); // link_target: blob
+
+				v.on_link(rec);
+			}
+			break;
+
+			default:
+				std::cerr << "unknown link section at " << r.tell() << std::endl;
+				return err::bad_link_tag;
+			}
+		}
+
+		if (r.tell() != l.links_end) {
+			std::cerr << "section ended at " << r.tell() << ", expected " << l.links_end << std::endl;
+			return err::unknown;
+		}
+
+		return err::none;
+	}
+
+	scanner::err scanner::read_content(reader& r, const layout& l, visitor& v, bool blobs) {
+		TRACE_SCOPE("scanner::read_content");
+
+//		std::cout << "content_start=" << r.tell() << ", content_end=" << l.content_end << std::endl;
+
+		while (r.tell() < l.content_end) {
+			if (!r.good())
+				return err::bad_data;
+
+			int8_t type = r.read_byte();
+
+			//std::cout << "[" << type << "]=" << r.tell() << std::endl;
+
+			switch (type) {
+			case 'L':
+				r.skip(9);
+				break;
+
+			case 'z':
+				r.skip(6);
+				break;
+
+			case 'o':
+				r.skip_blob();
+				break;
+
+			case 'M': {
+				r.skip(2);
+				r.skip_blob();
+			}
+					  break;
+
+			case 'B': {
+				v.on_tile(tile{
+					{
+						r.read_coord(),
+						r.read_coord(),
+					},
+					r.read_color()
+				});
+			}
+					  break;
+
+			case 'I': {
+				image i{};
+
+				i.bounds = { r.read_coord(), r.read_coord() };
+				i.color = r.read_color();
+				r.skip(3);
+				i.addr = r.read_medium();
+
+				v.on_image(i);
+			}
+					  break;
+
+			case 'F': {
+				form_record f{};
+
+				f.bounds = { r.read_coord(), r.read_coord() };
+				f.color = r.read_color();
+
+				f.type = r.read_short();
+				f.id = r.read_string_view();
+				f.value = r.read_string_view();
+
+				r.skip(3); // \xFF\xFF\xFF
+
+				v.on_form(f);
+			}
+					  break;
+
+			case 'T': {
+				text_record t{};
+
+				t.bounds = { r.read_coord(), r.read_coord() };
+				t.color = r.read_color();
+				t.font = r.read_byte();
+				t.data = r.read_string_view();
+
+				v.on_text(t);
+			}
+					  break;
+
+			case 'S': {
+				int32_t data_size = r.read_medium();
+				if (data_size < 0)
+					return err::bad_data;
+
+				size_t data_begin = r.tell();
+				size_t data_end = data_begin + data_size;
+
+				//std::cout << "data_size=" << data_size << std::endl;
+
+				if (!blobs) {
+					r.seek(data_end);
+					break;
+				}
+
+				while (r.tell() < data_end) {
+					blob_record b{};
+
+					b.addr = static_cast<uint32_t>(r.tell() - 3);
+
+					auto len = r.read_short();
+					if (len <= 0)
+						return err::bad_data;
+
+					b.data = r.read_view(len);
+					if (!r.good())
+						return err::bad_data;
+
+					v.on_blob(b);
+				}
+			}
+			break;
+
+			default:
+				return err::bad_content_tag;
+			}
+		}
+
+		// the last record ran past the end of the buffer
+		return r.good() ? err::none : err::bad_data;
+	}
+};
\ No newline at end of file
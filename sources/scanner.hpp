@@ -0,0 +1,109 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// streaming walk over an OBML v6 buffer; records are handed to a visitor
+	// as views into the buffer, nothing is materialized and no image is decoded
+	class scanner : private sf::NonCopyable {
+	public:
+		enum ver {
+			v6 = 6
+		};
+
+		enum err {
+			none,
+			version,
+			bad_link_tag,
+			bad_content_tag,
+			bad_data,
+			bad_path,
+			unknown
+		};
+
+		enum section {
+			links = 1 << 0,
+			content = 1 << 1,
+			blobs = 1 << 2, // encoded images at the end of the content section
+			all = links | content | blobs
+		};
+
+		struct link_record {
+			int8_t tag;
+			std::vector<rect> regions;
+
+			std::string_view type;
+			std::string_view href;
+		};
+
+		struct text_record {
+			rect bounds;
+			sf::Color color;
+
+			int8_t font;
+			std::string_view data;
+		};
+
+		struct form_record {
+			rect bounds;
+			sf::Color color;
+
+			int16_t type;
+			std::string_view id;
+			std::string_view value;
+		};
+
+		struct blob_record {
+			uint32_t addr; // image::addr of the tiles showing it
+			std::string_view data;
+		};
+
+		// every callback is optional; links and content may be visited from different threads
+		class visitor {
+		public:
+			virtual ~visitor() {}
+
+			virtual void on_header(const header& h) {}
+			virtual void on_link(const link_record& l) {}
+			virtual void on_tile(const tile& t) {}
+			virtual void on_image(const image& i) {}
+			virtual void on_text(const text_record& t) {}
+			virtual void on_form(const form_record& f) {}
+			virtual void on_blob(const blob_record& b) {}
+		};
+
+		struct layout {
+			size_t links_begin = 0;
+			size_t links_end = 0;
+			size_t content_end = 0;
+		};
+
+		explicit scanner(const sptr_t<const blob>& data);
+		~scanner();
+
+		// read only as much of the file as the sections need: without content
+		// or blobs that is the header, metadata and (with links) the links section
+		static sptr_t<const blob> load(const path& _path, int sections = all);
+
+		// the header alone, from the first few hundred bytes of the file
+		static err probe(const path& _path, header& h);
+
+		// header and metadata, then the requested sections in file order
+		err scan(visitor& v, int sections = all);
+
+		// the steps of scan(), for callers running sections on their own cursors
+		static err read_header(reader& r, header& h);
+		static err read_metadata(reader& r, const header& h, layout& l);
+		static err read_links(reader& r, const layout& l, visitor& v);
+		static err read_content(reader& r, const layout& l, visitor& v, bool blobs = true);
+
+	private:
+		// enough for the header and metadata of nearly every page
+		static const size_t prefix_size = 16 * 1024;
+
+		// enough for the header of nearly every page
+		static const size_t header_size = 512;
+
+		sptr_t<const blob> _data;
+	};
+};
\ No newline at end of file
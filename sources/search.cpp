@@ -0,0 +1,154 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	const sf::Color text_search::fill(255, 200, 0, 90);
+	const sf::Color text_search::current_fill(255, 120, 0, 150);
+
+	text_search::text_search() : _overlay(sf::Quads) {
+	}
+
+	text_search::~text_search() {
+	}
+
+	void text_search::build(const tiles& _tiles) {
+		TRACE_SCOPE("text_search::build");
+
+		clear();
+
+		for (const auto& i : _tiles) {
+			if (auto t = std::get_if<text>(&i)) {
+				if (t->data.empty())
+					continue;
+
+				auto folded = tokenizer::lower(t->data);
+
+				_runs.push_back({ static_cast<uint32_t>(_text.size()), static_cast<uint32_t>(folded.size()), t->bounds });
+				_text.append(folded).append("\n");
+			}
+		}
+
+		// hits come out of the buffer in order, so sort it by reading order once
+		std::vector<size_t> order(_runs.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+
+		std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			const auto& ra = _runs[a].bounds;
+			const auto& rb = _runs[b].bounds;
+			return ra.top != rb.top ? ra.top < rb.top : ra.left < rb.left;
+		});
+
+		std::string text;
+		std::vector<run> runs;
+
+		text.reserve(_text.size());
+		runs.reserve(_runs.size());
+
+		for (auto i : order) {
+			const auto& r = _runs[i];
+			runs.push_back({ static_cast<uint32_t>(text.size()), r.len, r.bounds });
+			text.append(_text, r.offset, r.len + 1);
+		}
+
+		_text.swap(text);
+		_runs.swap(runs);
+	}
+
+	void text_search::clear() {
+		_text.clear();
+		_runs.clear();
+		_query.clear();
+		_hits.clear();
+		_current = 0;
+		_overlay.clear();
+	}
+
+	bool text_search::find(const std::string& query) {
+		TRACE_SCOPE("text_search::find");
+
+		auto folded = tokenizer::lower(query);
+		if (folded == _query)
+			return false;
+
+		bool refine = !_query.empty() && folded.compare(0, _query.size(), _query) == 0;
+		_query = folded;
+
+		if (_query.empty() || _query.find('\n') != std::string::npos) {
+			_hits.clear();
+		}
+		else if (refine) {
+			// a longer query can only match runs that matched the shorter one
+			auto end = std::remove_if(_hits.begin(), _hits.end(), [this](size_t i) {
+				std::string_view data(_text.data() + _runs[i].offset, _runs[i].len);
+				return data.find(_query) == std::string_view::npos;
+			});
+
+			_hits.erase(end, _hits.end());
+		}
+		else {
+			_hits.clear();
+
+			// one scan of the whole buffer, the run index only moves forward
+			size_t r = 0;
+			for (size_t pos = _text.find(_query); pos != std::string::npos;) {
+				while (_runs[r].offset + _runs[r].len < pos)
+					r++;
+
+				_hits.push_back(r);
+
+				// next run
+				pos = _text.find(_query, _runs[r].offset + _runs[r].len + 1);
+			}
+		}
+
+		_current = 0;
+		update_overlay();
+
+		return true;
+	}
+
+	size_t text_search::get_count() const {
+		return _hits.size();
+	}
+
+	const rect& text_search::get_hit(size_t i) const {
+		return _runs[_hits[i]].bounds;
+	}
+
+	void text_search::set_current(size_t i) {
+		if (i >= _hits.size())
+			return;
+
+		set_color(_current, fill);
+		_current = i;
+		set_color(_current, current_fill);
+	}
+
+	const sf::VertexArray& text_search::get_overlay() const {
+		return _overlay;
+	}
+
+	void text_search::update_overlay() {
+		_overlay.resize(_hits.size() * 4);
+
+		for (size_t i = 0; i < _hits.size(); i++) {
+			const sf::FloatRect b = _runs[_hits[i]].bounds.to_float();
+			sf::Vertex* quad = &_overlay[i * 4];
+
+			quad[0].position = { b.left, b.top };
+			quad[1].position = { b.left + b.width, b.top };
+			quad[2].position = { b.left + b.width, b.top + b.height };
+			quad[3].position = { b.left, b.top + b.height };
+
+			set_color(i, i == _current ? current_fill : fill);
+		}
+	}
+
+	void text_search::set_color(size_t hit, const sf::Color& color) {
+		if (hit >= _hits.size())
+			return;
+
+		for (size_t i = 0; i < 4; i++)
+			_overlay[hit * 4 + i].color = color;
+	}
+};
\ No newline at end of file
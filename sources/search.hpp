@@ -0,0 +1,51 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// find-in-page over a page's text tiles
+	//
+	// build() folds every run into one flat lowercased buffer (off the UI thread);
+	// a query is a substring scan of that buffer, and a query extending the last one
+	// only re-checks the previous hits, so typing stays cheap on very large pages
+	class text_search : private sf::NonCopyable {
+	public:
+		static const sf::Color fill;
+		static const sf::Color current_fill;
+
+		text_search();
+		~text_search();
+
+		void build(const tiles& _tiles);
+		void clear();
+
+		// true when the hits changed
+		bool find(const std::string& query);
+
+		size_t get_count() const;
+		const rect& get_hit(size_t i) const;
+
+		// every hit in one batch, the current one in a stronger color
+		void set_current(size_t i);
+		const sf::VertexArray& get_overlay() const;
+
+	private:
+		struct run {
+			uint32_t offset; // into _text
+			uint32_t len;
+			rect bounds;
+		};
+
+		std::string _text; // lowercased runs in reading order, '\n' separated
+		std::vector<run> _runs;
+
+		std::string _query;
+		std::vector<size_t> _hits; // into _runs, in reading order
+		size_t _current = 0;
+
+		sf::VertexArray _overlay;
+
+		void update_overlay();
+		void set_color(size_t hit, const sf::Color& color);
+	};
+};
\ No newline at end of file
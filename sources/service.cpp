@@ -0,0 +1,323 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	service::service(const sptr_t<render::fonts>& fonts, size_t workers, size_t cache_size) :
+		_fonts(fonts),
+		_pool(workers),
+		_cache_size(std::max<size_t>(cache_size, 1))
+	{
+	}
+
+	service::~service() {
+	}
+
+	int service::run(std::istream& in, std::ostream& out) {
+#ifdef _WIN32
+		// inline page bytes must not go through CRLF translation
+		_setmode(_fileno(stdin), _O_BINARY);
+#endif
+
+		_out = &out;
+		std::list<std::future<void>> jobs;
+
+		for (;;) {
+			request r;
+			if (!read_request(in, r))
+				break;
+
+			if (!r.error.empty()) {
+				respond(r, "\"ok\":false,\"error\":\"" + json::escape(r.error) + "\"");
+				continue;
+			}
+
+			if (r.op == "quit") {
+				for (auto& i : jobs)
+					i.wait();
+
+				respond(r, "\"ok\":true");
+				break;
+			}
+
+			jobs.push_back(_pool.submit([this, r] { handle(r); }));
+
+			// keep the list short on long sessions
+			jobs.remove_if([](const std::future<void>& i) {
+				return i.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			});
+		}
+
+		for (auto& i : jobs)
+			i.wait();
+
+		_out->flush();
+		return 0;
+	}
+
+	bool service::read_request(std::istream& in, request& r) {
+		std::string line;
+
+		while (line.empty()) {
+			if (!std::getline(in, line))
+				return false;
+
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+		}
+
+		r.received.restart();
+
+		std::vector<std::string> fields;
+		std::stringstream ss(line);
+
+		for (std::string i; std::getline(ss, i, '\t');)
+			fields.push_back(i);
+
+		fields.resize(std::max<size_t>(fields.size(), 5));
+
+		r.id = fields[0];
+		r.op = fields[1];
+		r.source = fields[2];
+		r.dest = fields[3];
+		r.format = fields[4].empty() ? "png" : fields[4];
+
+		if (r.source.size() > 1 && r.source[0] == '@') {
+			std::string digits = r.source.substr(1);
+
+			// without a length the bytes that follow cannot be skipped, they are read as requests
+			if (digits.size() > 9 || digits.find_first_not_of("0123456789") != std::string::npos) {
+				r.error = "bad inline length";
+				return true;
+			}
+
+			size_t len = std::stoul(digits);
+
+			if (len > generator::max_size) {
+				r.error = "inline page too large";
+				in.ignore(len);
+				return true;
+			}
+
+			auto data = std::make_shared<blob>(len);
+			if (len > 0 && !in.read(data->data(), len))
+				return false;
+
+			r.data = data;
+		}
+
+		return true;
+	}
+
+	void service::handle(const request& r) {
+		TRACE_SCOPE("service::handle");
+
+		int64_t queued = r.received.getElapsedTime().asMicroseconds();
+		sf::Clock clock;
+
+		std::stringstream body;
+		bool cached = false;
+
+		try {
+			std::string result;
+
+			if (r.op == "stats")
+				result = do_stats();
+			else if (r.op == "render" || r.op == "export" || r.op == "links" || r.op == "text") {
+				auto p = get_page(r, cached);
+
+				if (p == nullptr || p->get_err() != parser::err::none) {
+					respond(r, "\"ok\":false,\"error\":\"parse failed (" + std::to_string(p ? p->get_err() : parser::err::bad_path) + ")\"");
+					return;
+				}
+
+				if (r.op == "render")
+					result = do_render(*p);
+				else if (r.op == "export")
+					result = do_export(*p, r);
+				else if (r.op == "links")
+					result = do_links(*p);
+				else
+					result = do_text(*p);
+			}
+			else {
+				respond(r, "\"ok\":false,\"error\":\"unknown op\"");
+				return;
+			}
+
+			int64_t elapsed = clock.getElapsedTime().asMicroseconds();
+
+			_requests++;
+			_hits += cached ? 1 : 0;
+			_total_us += elapsed;
+
+			for (int64_t max = _max_us; elapsed > max && !_max_us.compare_exchange_weak(max, elapsed);)
+				;
+
+			body << std::fixed << std::setprecision(3)
+				<< "\"ok\":true"
+				<< ",\"cached\":" << (cached ? "true" : "false")
+				<< ",\"queue_ms\":" << queued / 1000.0
+				<< ",\"ms\":" << elapsed / 1000.0
+				<< ",\"result\":" << result
+			;
+		}
+		catch (const std::exception& e) {
+			body.str("");
+			body << "\"ok\":false,\"error\":\"" << json::escape(e.what()) << "\"";
+		}
+
+		respond(r, body.str());
+	}
+
+	sptr_t<page> service::get_page(const request& r, bool& cached) {
+		std::string key;
+
+		if (r.data != nullptr) {
+			std::stringstream ss;
+			ss << "@" << std::hex << cache::hash(r.data->data(), r.data->size()) << ":" << r.data->size();
+			key = ss.str();
+		}
+		else {
+			path source(r.source);
+			if (!fs::is_regular_file(source))
+				return nullptr;
+
+			// a rewritten file gets a fresh entry, the stale one ages out
+			key = fs::absolute(source).u8string() + "@" + std::to_string(fs::last_write_time(source).time_since_epoch().count());
+		}
+
+		std::promise<sptr_t<page>> loading;
+		std::shared_future<sptr_t<page>> loaded;
+
+		{
+			std::lock_guard<std::mutex> lock(_cache_lock);
+
+			auto i = std::find_if(_cache.begin(), _cache.end(), [&](const entry& e) { return e.key == key; });
+			cached = i != _cache.end();
+
+			if (cached) {
+				_cache.splice(_cache.begin(), _cache, i);
+				loaded = i->loaded;
+			}
+			else {
+				loaded = loading.get_future().share();
+				_cache.push_front({ key, loaded });
+
+				if (_cache.size() > _cache_size)
+					_cache.pop_back();
+			}
+		}
+
+		// concurrent requests for the same page wait on the first load
+		if (!cached) {
+			TRACE_SCOPE("service::load");
+
+			sptr_t<page> p = r.data != nullptr
+				? std::make_shared<page>(r.data, path("inline-" + r.id))
+				: std::make_shared<page>(path(r.source));
+
+			p->set_fonts(_fonts);
+			loading.set_value(p);
+		}
+
+		return loaded.get();
+	}
+
+	std::string service::do_render(page& p) {
+		std::lock_guard<std::mutex> lock(_render_lock);
+
+		p.prepare();
+		p.render();
+
+		auto size = p.get_texture().getSize();
+
+		std::stringstream ss;
+		ss << "{\"width\":" << size.x
+			<< ",\"height\":" << size.y
+			<< ",\"tiles\":" << p.get_tiles().size()
+			<< ",\"links\":" << p.get_links().size()
+			<< ",\"images\":" << p.get_images().size()
+			<< "}";
+
+		return ss.str();
+	}
+
+	std::string service::do_export(page& p, const request& r) {
+		std::lock_guard<std::mutex> lock(_render_lock);
+
+		p.prepare();
+		p.render();
+
+		bool ok = p.export_page(r.dest, r.format.c_str());
+
+		std::stringstream ss;
+		ss << "{\"exported\":" << (ok ? "true" : "false")
+			<< ",\"dest\":\"" << json::escape(r.dest + p.get_path().stem().u8string() + "." + r.format) << "\""
+			<< "}";
+
+		return ss.str();
+	}
+
+	std::string service::do_links(page& p) {
+		std::stringstream ss;
+		ss << "[";
+
+		bool first = true;
+		for (const auto& i : p.get_links()) {
+			ss << (first ? "" : ",")
+				<< "{\"type\":\"" << json::escape(i.target.type) << "\""
+				<< ",\"href\":\"" << json::escape(i.target.href) << "\""
+				<< ",\"regions\":" << i.regions.size()
+				<< "}";
+			first = false;
+		}
+
+		ss << "]";
+		return ss.str();
+	}
+
+	std::string service::do_text(page& p) {
+		std::stringstream ss;
+		ss << "[";
+
+		bool first = true;
+		for (const auto& i : p.get_tiles()) {
+			if (auto t = std::get_if<text>(&i)) {
+				ss << (first ? "" : ",") << "\"" << json::escape(t->data) << "\"";
+				first = false;
+			}
+		}
+
+		ss << "]";
+		return ss.str();
+	}
+
+	std::string service::do_stats() {
+		size_t pages;
+		{
+			std::lock_guard<std::mutex> lock(_cache_lock);
+			pages = _cache.size();
+		}
+
+		size_t requests = _requests;
+
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(3)
+			<< "{\"workers\":" << _pool.size()
+			<< ",\"pending\":" << _pool.pending()
+			<< ",\"pages\":" << pages
+			<< ",\"requests\":" << requests
+			<< ",\"hits\":" << _hits
+			<< ",\"avg_ms\":" << (requests > 0 ? _total_us / 1000.0 / requests : 0.0)
+			<< ",\"max_ms\":" << _max_us / 1000.0
+			<< "}";
+
+		return ss.str();
+	}
+
+	void service::respond(const request& r, const std::string& body) {
+		std::string line = "{\"id\":\"" + json::escape(r.id) + "\",\"op\":\"" + json::escape(r.op) + "\"," + body + "}\n";
+
+		std::lock_guard<std::mutex> lock(_out_lock);
+		*_out << line << std::flush;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "main.hpp"
+
+#ifdef _WIN32
+	#include <io.h>
+	#include <fcntl.h>
+#endif
+
+namespace obml_renderer {
+	// long-running render daemon: reads jobs from a stream, answers with one JSON line each
+	//
+	// request:  <id> TAB <op> TAB <source> [TAB <dest> [TAB <format>]] LF
+	//   op      render | export | links | text | stats | quit
+	//   source  path to an .obml file, or @<n> followed by n raw bytes after the LF
+	//
+	// response: {"id":..,"op":..,"ok":true,"cached":..,"queue_ms":..,"ms":..,"result":..}
+	//           {"id":..,"op":..,"ok":false,"error":".."}
+	class service : private sf::NonCopyable {
+	public:
+		service(const sptr_t<render::fonts>& fonts, size_t workers, size_t cache_size);
+		~service();
+
+		// serve until quit or end of input; jobs complete out of order, quit is answered last
+		int run(std::istream& in, std::ostream& out);
+
+	private:
+		struct request {
+			std::string id;
+			std::string op;
+			std::string source;
+			std::string dest;
+			std::string format;
+
+			sptr_t<const blob> data; // inline bytes
+			std::string error; // answered without running when set
+			sf::Clock received;
+		};
+
+		struct entry {
+			std::string key;
+			std::shared_future<sptr_t<page>> loaded;
+		};
+
+		sptr_t<render::fonts> _fonts;
+		pool _pool;
+
+		std::ostream* _out = nullptr;
+		std::mutex _out_lock;
+
+		// sf::Font rasterization and the offscreen targets are not thread safe
+		std::mutex _render_lock;
+
+		// warm pages, most recently used first
+		std::list<entry> _cache;
+		size_t _cache_size;
+		std::mutex _cache_lock;
+
+		std::atomic<size_t> _requests{ 0 };
+		std::atomic<size_t> _hits{ 0 };
+		std::atomic<int64_t> _total_us{ 0 };
+		std::atomic<int64_t> _max_us{ 0 };
+
+		bool read_request(std::istream& in, request& r);
+		void handle(const request& r);
+
+		sptr_t<page> get_page(const request& r, bool& cached);
+
+		std::string do_render(page& p);
+		std::string do_export(page& p, const request& r);
+		std::string do_links(page& p);
+		std::string do_text(page& p);
+		std::string do_stats();
+
+		void respond(const request& r, const std::string& body);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	namespace tokenizer {
+		sf::Uint32 lower(sf::Uint32 c) {
+			if (c < 0x80)
+				return c >= 'A' && c <= 'Z' ? c + 0x20 : c;
+
+			if ((c >= 0xC0 && c <= 0xDE && c != 0xD7)	// Latin-1
+				|| (c >= 0x391 && c <= 0x3AB)			// Greek
+				|| (c >= 0x410 && c <= 0x42F))			// Cyrillic
+				return c + 0x20;
+
+			if (c >= 0x400 && c <= 0x40F)				// Cyrillic with diacritics, Ё
+				return c + 0x50;
+
+			return c;
+		}
+
+		std::string lower(std::string_view utf8) {
+			std::string ret;
+			ret.reserve(utf8.size());
+
+			for (auto i = utf8.begin(); i != utf8.end();) {
+				sf::Uint32 c = 0;
+				i = sf::Utf8::decode(i, utf8.end(), c);
+				sf::Utf8::encode(lower(c), std::back_inserter(ret));
+			}
+
+			return ret;
+		}
+
+		bool is_word(sf::Uint32 c) {
+			if (c < 0x80)
+				return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+
+			// Latin-1 punctuation and symbols, general punctuation, CJK symbols
+			if (c < 0xC0 || c == 0xD7 || c == 0xF7)
+				return false;
+
+			if ((c >= 0x2000 && c <= 0x2BFF) || (c >= 0x3000 && c <= 0x303F) || (c >= 0xFF00 && c <= 0xFF0F))
+				return false;
+
+			return true;
+		}
+
+		void split(std::string_view utf8, const std::function<void(std::string_view, size_t, size_t)>& fn) {
+			std::string word;
+			size_t begin = 0;
+
+			for (auto i = utf8.begin(); i != utf8.end();) {
+				auto start = i;
+				sf::Uint32 c = 0;
+				i = sf::Utf8::decode(i, utf8.end(), c);
+
+				if (is_word(c)) {
+					if (word.empty())
+						begin = start - utf8.begin();
+
+					sf::Utf8::encode(lower(c), std::back_inserter(word));
+				}
+				else if (!word.empty()) {
+					fn(word, begin, (start - utf8.begin()) - begin);
+					word.clear();
+				}
+			}
+
+			if (!word.empty())
+				fn(word, begin, utf8.size() - begin);
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// word splitting and case folding of UTF-8 page text, shared by the index and in-page search
+	namespace tokenizer {
+		// simple case folding: ASCII, Latin-1, Greek and Cyrillic capitals
+		sf::Uint32 lower(sf::Uint32 c);
+		std::string lower(std::string_view utf8);
+
+		// letters and digits; punctuation, symbols and spaces separate words
+		bool is_word(sf::Uint32 c);
+
+		// calls fn with each lowercased word and its byte offset and length in the input
+		void split(std::string_view utf8, const std::function<void(std::string_view word, size_t offset, size_t len)>& fn);
+	};
+};
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	struct event {
+		const char* name;
+		int64_t begin;
+		int64_t duration;
+		uint32_t tid;
+	};
+
+	std::atomic<bool> trace::_enabled{ false };
+
+	static std::mutex _lock;
+	static std::vector<event> _events;
+	static path _out;
+	static const auto _origin = std::chrono::steady_clock::now();
+
+	trace::scope::scope(const char* name) : _name(name) {
+		_begin = _enabled.load(std::memory_order_relaxed) ? now() : -1;
+	}
+
+	trace::scope::~scope() {
+		if (_begin >= 0)
+			record(_name, _begin, now());
+	}
+
+	bool trace::start(const path& _path) {
+		std::lock_guard<std::mutex> guard(_lock);
+
+		_out = _path;
+		_events.clear();
+		_events.reserve(1 << 16);
+
+		_enabled = true;
+		return true;
+	}
+
+	bool trace::stop() {
+		if (!_enabled.exchange(false))
+			return false;
+
+		std::lock_guard<std::mutex> guard(_lock);
+
+		std::ofstream out(_out, std::ios::out | std::ios::trunc);
+		if (!out.is_open())
+			return false;
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		for (size_t i = 0; i < _events.size(); i++) {
+			const event& e = _events[i];
+
+			out
+				<< (i > 0 ? "," : "") << "\n"
+				<< "{\"name\":\"" << e.name << "\",\"cat\":\"obml\",\"ph\":\"X\""
+				<< ",\"ts\":" << e.begin << ",\"dur\":" << e.duration
+				<< ",\"pid\":1,\"tid\":" << e.tid << "}"
+			;
+		}
+
+		out << "\n]}\n";
+
+#if defined __Debug__
+		std::cout << "Trace: " << _events.size() << " events written to '" << _out.u8string() << "'" << std::endl;
+#endif
+		_events.clear();
+
+		return out.good();
+	}
+
+	bool trace::is_enabled() {
+		return _enabled.load(std::memory_order_relaxed);
+	}
+
+	int64_t trace::now() {
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - _origin
+		).count();
+	}
+
+	void trace::record(const char* name, int64_t begin, int64_t end) {
+		static std::atomic<uint32_t> next_tid{ 1 };
+		thread_local uint32_t tid = next_tid++;
+
+		std::lock_guard<std::mutex> guard(_lock);
+		if (_enabled)
+			_events.push_back({ name, begin, end - begin, tid });
+	}
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// Chrome trace-event recorder, see chrome://tracing or ui.perfetto.dev
+	class trace : private sf::NonCopyable {
+	public:
+		class scope : private sf::NonCopyable {
+		public:
+			explicit scope(const char* name);
+			~scope();
+
+		private:
+			const char* _name;
+			int64_t _begin; // -1 when tracing was off at entry
+		};
+
+		static bool start(const path& _path);
+		static bool stop();
+
+		static bool is_enabled();
+
+	private:
+		static std::atomic<bool> _enabled;
+
+		static int64_t now();
+		static void record(const char* name, int64_t begin, int64_t end);
+	};
+};
+
+// __Trace__ is set in main.hpp; without it scopes compile to nothing
+#if defined __Trace__
+	#define TRACE_CONCAT_(a, b) a##b
+	#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+	#define TRACE_SCOPE(name) obml_renderer::trace::scope TRACE_CONCAT(_trace_, __LINE__)(name)
+#else
+	#define TRACE_SCOPE(name)
+#endif
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	namespace uri {
+		struct parts {
+			std::string_view scheme;	// without ':'
+			std::string_view authority;	// with leading "//", if any
+			std::string_view path;
+			std::string_view query;		// with leading '?', if any
+			std::string_view fragment;	// with leading '#', if any
+		};
+
+		static parts split(std::string_view s) {
+			parts ret;
+
+			if (has_scheme(s)) {
+				auto colon = s.find(':');
+				ret.scheme = s.substr(0, colon);
+				s.remove_prefix(colon + 1);
+			}
+
+			if (s.compare(0, 2, "//") == 0) {
+				auto end = s.find_first_of("/?#", 2);
+				ret.authority = s.substr(0, end);
+				s.remove_prefix(ret.authority.size());
+			}
+
+			auto hash = s.find('#');
+			if (hash != std::string_view::npos) {
+				ret.fragment = s.substr(hash);
+				s = s.substr(0, hash);
+			}
+
+			auto query = s.find('?');
+			if (query != std::string_view::npos) {
+				ret.query = s.substr(query);
+				s = s.substr(0, query);
+			}
+
+			ret.path = s;
+			return ret;
+		}
+
+		bool has_scheme(std::string_view ref) {
+			if (ref.empty() || !isalpha(static_cast<uint8_t>(ref[0])))
+				return false;
+
+			for (char c : ref) {
+				if (c == ':')
+					return true;
+
+				if (!isalnum(static_cast<uint8_t>(c)) && c != '+' && c != '-' && c != '.')
+					return false;
+			}
+
+			return false;
+		}
+
+		std::string resolve(std::string_view base, std::string_view ref) {
+			if (base.empty() || has_scheme(ref))
+				return std::string(ref);
+
+			parts b = split(base), r = split(ref);
+			std::string ret;
+
+			ret.reserve(base.size() + ref.size());
+			if (!b.scheme.empty())
+				ret.append(b.scheme).append(":");
+
+			if (!r.authority.empty()) {
+				ret.append(r.authority).append(remove_dot_segments(r.path)).append(r.query);
+			}
+			else {
+				ret.append(b.authority);
+
+				if (r.path.empty())
+					ret.append(b.path).append(r.query.empty() ? b.query : r.query);
+				else {
+					std::string merged;
+
+					if (r.path[0] == '/')
+						merged = r.path;
+					else if (!b.authority.empty() && b.path.empty())
+						merged.append("/").append(r.path);
+					else
+						merged.append(b.path.substr(0, b.path.rfind('/') + 1)).append(r.path);
+
+					ret.append(remove_dot_segments(merged)).append(r.query);
+				}
+			}
+
+			return ret.append(r.fragment);
+		}
+
+		std::string remove_dot_segments(std::string_view in) {
+			std::string out;
+			out.reserve(in.size());
+
+			while (!in.empty()) {
+				if (in.compare(0, 3, "../") == 0)
+					in.remove_prefix(3);
+				else if (in.compare(0, 2, "./") == 0)
+					in.remove_prefix(2);
+				else if (in.compare(0, 3, "/./") == 0)
+					in.remove_prefix(2);
+				else if (in == "/.")
+					in = "/";
+				else if (in.compare(0, 4, "/../") == 0 || in == "/..") {
+					in = in.size() == 3 ? std::string_view("/") : in.substr(3);
+					auto slash = out.rfind('/');
+					out.erase(slash == std::string::npos ? 0 : slash);
+				}
+				else if (in == "." || in == "..")
+					in = {};
+				else {
+					auto end = in.find('/', 1);
+					out.append(in.substr(0, end));
+					in.remove_prefix(end == std::string_view::npos ? in.size() : end);
+				}
+			}
+
+			return out;
+		}
+	};
+};
\ No newline at end of file
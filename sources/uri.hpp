@@ -0,0 +1,16 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// just enough RFC 3986 for page links
+	namespace uri {
+		bool has_scheme(std::string_view ref);
+
+		// reference resolution against an absolute base, section 5.2
+		std::string resolve(std::string_view base, std::string_view ref);
+
+		// section 5.2.4
+		std::string remove_dot_segments(std::string_view _path);
+	};
+};
\ No newline at end of file
@@ -1,6 +1,26 @@
 #include "viewer.hpp"
 
 namespace obml_renderer {
+	static const char* ui_font = "C:\\Windows\\Fonts\\DejaVuSansMono_0.ttf";
+	static const float ui_font_size = 14.f;
+
+	// code points kept per font id across sessions: opening a page waits for them to be rasterized
+	static const size_t max_saved_glyphs = 2048;
+
+	static void merge_charsets(charsets& dest, const charsets& source) {
+		for (const auto& i : source) {
+			auto& set = dest[i.first];
+
+			for (auto j = i.second.begin(); j != i.second.end() && set.size() < max_saved_glyphs; ++j)
+				set.insert(*j);
+		}
+	}
+
+	// down to the page's coarsest level of detail, see render::lod_levels
+	static const float min_zoom = 1.f / 256.f;
+	static const float max_zoom = 4.f;
+	static const float zoom_step = 1.25f; // per key press or wheel notch
+
 	viewer::viewer(const sf::VideoMode& mode) :
 		_window(mode, "OBML Renderer", sf::Style::None),
 		_fonts(std::make_shared<render::fonts>()),
@@ -8,8 +28,7 @@ namespace obml_renderer {
 
 		_window.setVerticalSyncEnabled(true);
 		setup_imgui();
-
-		_fonts->font.loadFromFile("C:\\Windows\\Fonts\\ARIALUNI.ttf");
+		setup_fonts();
 
 #ifdef _WIN32
 		setup_openfilename();
@@ -17,25 +36,71 @@ namespace obml_renderer {
 	}
 
 	viewer::~viewer() {
+		wait_fonts();
+		wait_search();
+
+		if (_fonts_key != 0)
+			cache::save_charsets(cache::get_path("glyphs", _fonts_key, "bin"), _fonts_key, _charsets);
+
 		ImGui::SFML::Shutdown();
 		_window.close();
 	}
 
 	void viewer::setup_imgui() {
-		ImGui::SFML::Init(_window);
+		ImGui::SFML::Init(_window, false);
 
 		ImGui::StyleColorsLight();
 		ImGui::GetStyle().FrameRounding = 4.f;
 
 		ImGuiIO& io = ImGui::GetIO();
-		io.FontDefault = io.Fonts->AddFontFromFileTTF(
-			"C:\\Windows\\Fonts\\DejaVuSansMono_0.ttf", 14.f, NULL,
-			io.Fonts->GetGlyphRangesCyrillic()
-		);
+		const ImWchar* ranges = io.Fonts->GetGlyphRangesCyrillic();
+
+		size_t ranges_len = 0;
+		while (ranges[ranges_len] != 0)
+			ranges_len++;
+
+		// key: font file, pixel size and glyph ranges
+		uint64_t key = cache::hash_file(ui_font);
+		key = cache::hash(reinterpret_cast<const char*>(&ui_font_size), sizeof ui_font_size, key);
+		key = cache::hash(reinterpret_cast<const char*>(ranges), ranges_len * sizeof(ImWchar), key);
+
+		path atlas_path = cache::get_path("imgui", key, "atlas");
+
+		if (!cache::load_atlas(atlas_path, key, *io.Fonts)) {
+			// without the font file ImGui's built-in one is used, and not cached
+			if (io.Fonts->AddFontFromFileTTF(ui_font, ui_font_size, NULL, ranges) != nullptr)
+				cache::save_atlas(atlas_path, key, *io.Fonts);
+			else
+				io.Fonts->AddFontDefault();
+		}
+
+		if (!io.Fonts->Fonts.empty())
+			io.FontDefault = io.Fonts->Fonts.back();
 
 		ImGui::SFML::UpdateFontTexture();
 	}
 
+	void viewer::setup_fonts() {
+		_fonts->font.loadFromFile(render::default_font);
+
+		// hash the font and re-rasterize the code points seen in previous sessions off-thread
+		_warmup = std::async(std::launch::async, [this, sizes = _fonts->font_sizes] {
+			_fonts_key = cache::hash_file(render::default_font);
+
+			charsets saved;
+
+			if (_fonts_key != 0 && cache::load_charsets(cache::get_path("glyphs", _fonts_key, "bin"), _fonts_key, saved)) {
+				merge_charsets(_charsets, saved); // files from before the cap may hold more
+				_fonts->warm(_charsets, sizes);
+			}
+		});
+	}
+
+	void viewer::wait_fonts() {
+		if (_warmup.valid())
+			_warmup.get();
+	}
+
 	void viewer::open() {
 		sf::Event e;
 		sf::Clock _clock;
@@ -67,7 +132,10 @@ namespace obml_renderer {
 			0.f, 0.f, float(_window.getSize().x), _drawing_offset.y
 		};
 
+		sf::Clock _stage_clock;
+
 		while (_window.isOpen()) {
+			_stage_clock.restart();
 
 			ImGui::SFML::Update(_window, _clock.restart());
 
@@ -82,22 +150,57 @@ namespace obml_renderer {
 						0.f, 0.f,
 						float(e.size.width), float(e.size.height)
 					});
-					_view.reset({
-						_scroll.position.x, -_scroll.position.y,
-						float(e.size.width), float(e.size.height)
-					});
+					clamp_scroll();
+					update_view();
 
 					_window_border.setSize({ float(e.size.width) - 2, float(e.size.height) - 2});
 				}
 
 				else if (e.type == sf::Event::KeyPressed) {
+					sf::Vector2i center(_window.getSize() / 2u);
+
 					switch (e.key.code) {
 					case sf::Keyboard::Up:
-						set_scroll_page_y(25.f);
+						set_scroll_page_y(25.f, 64.f / _zoom);
 						break;
 
 					case sf::Keyboard::Down:
-						set_scroll_page_y(-25.f);
+						set_scroll_page_y(-25.f, 64.f / _zoom);
+						break;
+
+					case sf::Keyboard::Left:
+						set_scroll_page_x(-1.f, 64.f / _zoom);
+						break;
+
+					case sf::Keyboard::Right:
+						set_scroll_page_x(1.f, 64.f / _zoom);
+						break;
+
+					case sf::Keyboard::Add:
+					case sf::Keyboard::Equal:
+						if (e.key.control)
+							set_zoom(_zoom * zoom_step, center);
+						break;
+
+					case sf::Keyboard::Subtract:
+					case sf::Keyboard::Hyphen:
+						if (e.key.control)
+							set_zoom(_zoom / zoom_step, center);
+						break;
+
+					case sf::Keyboard::Num0:
+						if (e.key.control)
+							set_zoom(1.f, center);
+						break;
+
+					case sf::Keyboard::O:
+						if (!ImGui::GetIO().WantCaptureKeyboard)
+							toggle_overview();
+						break;
+
+					case sf::Keyboard::F3:
+						if (is_search_ready() && _search.get_count() > 0)
+							jump_to_hit(e.key.shift ? _search_current + _search.get_count() - 1 : _search_current + 1);
 						break;
 
 					case sf::Keyboard::Escape:
@@ -105,23 +208,30 @@ namespace obml_renderer {
 						break;
 					}
 				}
-				else if (e.type == sf::Event::MouseWheelScrolled)
-					set_scroll_page_y(e.mouseWheelScroll.delta);
+				else if (e.type == sf::Event::MouseWheelScrolled) {
+					if (sf::Keyboard::isKeyPressed(sf::Keyboard::LControl) || sf::Keyboard::isKeyPressed(sf::Keyboard::RControl))
+						set_zoom(_zoom * std::pow(zoom_step, e.mouseWheelScroll.delta), { e.mouseWheelScroll.x, e.mouseWheelScroll.y });
+					else
+						set_scroll_page_y(e.mouseWheelScroll.delta, 64.f / _zoom);
+				}
 
 				else if (e.type == sf::Event::MouseButtonReleased) {
 					if (e.mouseButton.button == sf::Mouse::Button::Left && _page != nullptr) {
-						if (!ImGui::GetIO().WantCaptureMouse) {
+						// the pixel through the view: scroll, zoom and the menu bar offset
+						sf::Vector2f at = _window.mapPixelToCoords({ e.mouseButton.x, e.mouseButton.y }, _view);
+
+						if (!ImGui::GetIO().WantCaptureMouse && _overview)
+							leave_overview(at);
+
+						else if (!ImGui::GetIO().WantCaptureMouse) {
 							bool found = false;
 
 							for (auto& i : _page->get_links()) {
 								if (!i.target.type.empty())
 									for (const auto& j : i.regions) {
-										if (j.contains((float)e.mouseButton.x, e.mouseButton.y - _scroll.position.y)) {
-											_selector.show(
-												{ j.left, j.top + _scroll.position.y + _drawing_offset.y },
-												{ j.width, j.height },
-												&i
-											);
+										if (j.contains(static_cast<int32_t>(std::floor(at.x)), static_cast<int32_t>(std::floor(at.y)))) {
+											const sf::FloatRect b = j.to_float();
+											_selector.show({ b.left, b.top }, { b.width, b.height }, &i);
 											found = true;
 										}
 									}
@@ -152,23 +262,39 @@ namespace obml_renderer {
 				}
 			}
 
+			_frame_profiler.push("events", _stage_clock.restart());
+
 			_window.clear(sf::Color::White);
 
 			draw_main_bar();
 			draw_info();
+			draw_profiler();
 			//draw_tabs();
 
+			sf::Time _imgui_time = _stage_clock.restart();
+
 			if (_page != nullptr) {
 				_window.setView(_view);
 				_page->render(_window);
+
+				// the index is rewritten while it builds
+				if (is_search_ready() && _search.get_count() > 0)
+					_window.draw(_search.get_overlay());
+
+				_window.draw(_selector);
+
 				_window.setView(_window.getDefaultView());
 			}
 
-			_window.draw(_selector);
 			_window.draw(_window_border);
 
+			_frame_profiler.push("page", _stage_clock.restart());
+
 			ImGui::SFML::Render(_window);
+			_frame_profiler.push("imgui", _imgui_time + _stage_clock.restart());
+
 			_window.display();
+			_frame_profiler.push("present", _stage_clock.restart());
 		}
 	}
 
@@ -181,20 +307,32 @@ namespace obml_renderer {
 			if (ImGui::MenuItem("Open")) {
 #ifdef _WIN32
 				if (GetOpenFileName(&_ofn) == TRUE) {
+					wait_search();
+
 					if (_page != nullptr)
 						_page.reset();
 
 					path temp(_path);
 					std::cout << "Loading page from '" << temp.stem().u8string() << "'..." << std::endl;
 
+					wait_fonts();
+
 					_page = std::make_unique<page>(temp);
 
 					_page->set_fonts(_fonts);
+					_page->set_merge_tiles(merge_tiles);
+
+					// only the bands around the view are built, as the first frames draw them
 					_page->prepare();
-					_page->render();
+
+					merge_charsets(_charsets, _page->get_charsets());
+
+					_load_profiler.merge(_page->get_profiler());
 
 					_selector.hide();
 					reset_scroll();
+
+					index_search();
 				}
 #endif
 			}
@@ -203,25 +341,41 @@ namespace obml_renderer {
 				if (ImGui::MenuItem("Info", 0, show_page_info))
 					show_page_info = !show_page_info;
 
+				if (ImGui::MenuItem("Merge tiles", 0, merge_tiles)) {
+					merge_tiles = !merge_tiles;
+
+					_page->set_merge_tiles(merge_tiles);
+					_page->prepare();
+				}
+
 				if (ImGui::BeginMenu("Save as...")) {
 
-					if (ImGui::MenuItem("JPEG"))
+					// the offscreen texture is only drawn for exports
+					if (ImGui::MenuItem("JPEG")) {
+						_page->render();
 						_page->export_page("", "jpeg");
+					}
 
-					if (ImGui::MenuItem("PNG"))
+					if (ImGui::MenuItem("PNG")) {
+						_page->render();
 						_page->export_page("", "png");
+					}
 
 					ImGui::EndMenu();
 				}
 
 				if (ImGui::BeginMenu("Fonts", _page != nullptr)) {
-					ImGui::SliderInt("medium", reinterpret_cast<int*>(&_fonts->font_sizes[2].size), 1, 32);
-					ImGui::SliderInt("medium bold", reinterpret_cast<int*>(&_fonts->font_sizes[3].size), 1, 32);
-					ImGui::SliderInt("large", reinterpret_cast<int*>(&_fonts->font_sizes[4].size), 1, 32);
-					ImGui::SliderInt("large bold", reinterpret_cast<int*>(&_fonts->font_sizes[5].size), 1, 32);
-					ImGui::SliderInt("small", reinterpret_cast<int*>(&_fonts->font_sizes[6].size), 1, 32);
+					bool changed = false;
+
+					changed |= ImGui::SliderInt("medium", reinterpret_cast<int*>(&_fonts->font_sizes[2].size), 1, 32);
+					changed |= ImGui::SliderInt("medium bold", reinterpret_cast<int*>(&_fonts->font_sizes[3].size), 1, 32);
+					changed |= ImGui::SliderInt("large", reinterpret_cast<int*>(&_fonts->font_sizes[4].size), 1, 32);
+					changed |= ImGui::SliderInt("large bold", reinterpret_cast<int*>(&_fonts->font_sizes[5].size), 1, 32);
+					changed |= ImGui::SliderInt("small", reinterpret_cast<int*>(&_fonts->font_sizes[6].size), 1, 32);
 
-					if (ImGui::Button("APPLY"))
+					// live preview: only the runs of the dragged size are re-laid out,
+					// exports render afresh so there is nothing else to apply
+					if (changed)
 						_page->update_fonts();
 
 					ImGui::EndMenu();
@@ -230,6 +384,32 @@ namespace obml_renderer {
 				ImGui::EndMenu();
 			}
 
+			if (ImGui::BeginMenu("Zoom", _page != nullptr)) {
+				sf::Vector2i center(_window.getSize() / 2u);
+
+				if (ImGui::MenuItem("Zoom in", "Ctrl +"))
+					set_zoom(_zoom * zoom_step, center);
+
+				if (ImGui::MenuItem("Zoom out", "Ctrl -"))
+					set_zoom(_zoom / zoom_step, center);
+
+				if (ImGui::MenuItem("Actual size", "Ctrl 0"))
+					set_zoom(1.f, center);
+
+				if (ImGui::MenuItem("Overview", "O", _overview))
+					toggle_overview();
+
+				ImGui::EndMenu();
+			}
+
+			if (_page != nullptr && _zoom != 1.f)
+				ImGui::TextDisabled("%.0f%%", _zoom * 100.f);
+
+			if (ImGui::MenuItem("Profiler", 0, show_profiler))
+				show_profiler = !show_profiler;
+
+			draw_search();
+
 			ImGui::Separator();
 			if (ImGui::MenuItem("Quit", ""))
 				_window.close();
@@ -278,6 +458,73 @@ namespace obml_renderer {
 		}
 	}
 
+	void viewer::draw_search() {
+		if (_page == nullptr)
+			return;
+
+		ImGui::Separator();
+
+		if (!is_search_ready()) {
+			ImGui::TextDisabled("Indexing text...");
+			return;
+		}
+
+		ImGui::SetNextItemWidth(180.f);
+		bool changed = ImGui::InputTextWithHint("##search", "Find in page", _search_query, sizeof _search_query);
+
+		// Enter in the box steps to the next hit, F3 does it from anywhere
+		bool next = ImGui::IsItemActive() && ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Enter));
+
+		if (changed && _search.find(_search_query)) {
+			_search_current = 0;
+			if (_search.get_count() > 0)
+				jump_to_hit(0);
+		}
+		else if (next && _search.get_count() > 0)
+			jump_to_hit(_search_current + 1);
+
+		if (_search_query[0] != '\0') {
+			if (_search.get_count() > 0)
+				ImGui::Text("%zu/%zu", _search_current + 1, _search.get_count());
+			else
+				ImGui::TextDisabled("no matches");
+		}
+	}
+
+	void viewer::index_search() {
+		_search_query[0] = '\0';
+		_search_current = 0;
+
+		// the previous page's hits go before the build thread starts writing
+		_search.clear();
+
+		// the page is only read while the index is built, rendering carries on
+		_search_index = std::async(std::launch::async, [this] {
+			_search.build(_page->get_tiles());
+		});
+	}
+
+	void viewer::wait_search() {
+		if (_search_index.valid())
+			_search_index.get();
+	}
+
+	bool viewer::is_search_ready() {
+		if (_search_index.valid() && _search_index.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			return false;
+
+		wait_search();
+		return true;
+	}
+
+	void viewer::jump_to_hit(size_t i) {
+		_search_current = i % _search.get_count();
+		_search.set_current(_search_current);
+
+		const rect& hit = _search.get_hit(_search_current);
+		set_scroll_to(hit.top - _view.getSize().y / 3.f);
+	}
+
 	void viewer::draw_info() {
 		if (!show_page_info)
 			return;
@@ -310,6 +557,35 @@ namespace obml_renderer {
 			ImGui::BulletText("Size: %dKB", _header.data_len / 1024);
 			ImGui::BulletText("Version: %d", _header.version);
 			ImGui::BulletText("Resolution: %dx%d", _header.size.x, _header.size.y);
+
+			const geometry::cull_stats& _cull = _page->get_cull_stats();
+			ImGui::BulletText("Culled: %zu of %zu tiles covered, %zu blank", _cull.covered, _cull.tiles, _cull.blank);
+
+			const geometry::merge_stats& _merge = _page->get_merge_stats();
+			if (merge_tiles && _merge.before > 0)
+				ImGui::BulletText("Tiles: %zu merged into %zu, %.0f%% less fill",
+					_merge.before, _merge.after,
+					100.0 - 100.0 * _merge.area_after / std::max<uint64_t>(_merge.area_before, 1)
+				);
+
+			// textures hold mip levels too, a third on top of the base level;
+			// addresses with the same content share one
+			std::unordered_set<const sf::Texture*> textures;
+			size_t texture_bytes = 0;
+			for (const auto& i : _page->get_images())
+				if (i.texture != nullptr && textures.insert(i.texture.get()).second)
+					texture_bytes += static_cast<size_t>(i.texture->getSize().x) * i.texture->getSize().y * 4 * 4 / 3;
+
+			ImGui::BulletText("Images: %zu, %zu distinct, %zuKB of textures", _page->get_images().size(), textures.size(), texture_bytes / 1024);
+
+			image_cache::stats _images = image_cache::shared().get_stats();
+			ImGui::BulletText("Image cache: %zu live, %zuKB, %zu of %zu lookups hit (%.0f%%)",
+				_images.live, _images.bytes / 1024, _images.hits, _images.lookups,
+				100.0 * _images.hits / std::max<size_t>(_images.lookups, 1)
+			);
+
+			interner& _strings = _page->get_strings();
+			ImGui::BulletText("Strings: %zu unique, %zuKB (%zuKB repeated)", _strings.get_count(), _strings.get_bytes() / 1024, _strings.get_saved() / 1024);
 			ImGui::Bullet();
 			ImGui::TextWrapped("Title: %s", _header.title.c_str());
 
@@ -333,7 +609,7 @@ namespace obml_renderer {
 			ImGui::Separator();
 			if (_region != nullptr) {
 				ImGui::BulletText(
-					"Dimension: %.0fx%.0f, %.0fx%.0f",
+					"Dimension: %dx%d, %dx%d",
 					_region->regions.front().top, _region->regions.front().left,
 					_region->regions.front().width, _region->regions.front().height
 				);
@@ -341,14 +617,16 @@ namespace obml_renderer {
 
 				ImGui::BulletText("Target:"); ImGui::SameLine();
 				ImGui::InputText("##target",
-					_region->target.href.data(),
+					const_cast<char*>(_region->target.href.c_str()),
 					_region->target.href.size() + 1,
 					ImGuiInputTextFlags_AutoSelectAll
 					| ImGuiInputTextFlags_ReadOnly
 				);
 
-				if (ImGui::Button("EXPORT"))
+				if (ImGui::Button("EXPORT")) {
+					_page->render();
 					_page->export_region("", _region->regions.front());
+				}
 			}
 			else
 				ImGui::Text("EMPTY");
@@ -356,48 +634,175 @@ namespace obml_renderer {
 		ImGui::End();
 	}
 
+	void viewer::draw_profiler() {
+		if (!show_profiler)
+			return;
+
+		const ImGuiContext& ctx = *ImGui::GetCurrentContext();
+		float h = ctx.NextWindowData.MenuBarOffsetMinVal.y + ctx.FontBaseSize + ctx.Style.FramePadding.y; // main menu bar height
+
+		static const ImGuiWindowFlags flags{
+			ImGuiWindowFlags_AlwaysAutoResize
+			| ImGuiWindowFlags_NoResize
+			| ImGuiWindowFlags_NoSavedSettings
+		};
+
+		const float dist = 12.f;
+		ImGui::SetNextWindowPos({ dist, dist + h }, ImGuiCond_Always);
+
+		if (ImGui::Begin("Profiler", &show_profiler, flags)) {
+			ImGui::Text("FRAME");
+			ImGui::Separator();
+			draw_stages(_frame_profiler);
+
+			ImGui::Text(" ");
+			ImGui::Text("LOAD");
+			ImGui::Separator();
+			if (_load_profiler.get_stages().empty())
+				ImGui::Text("EMPTY");
+			else
+				draw_stages(_load_profiler);
+		}
+		ImGui::End();
+	}
+
+	void viewer::draw_stages(const profiler& p) {
+		char overlay[64];
+
+		for (const auto& i : p.get_stages()) {
+			snprintf(overlay, sizeof overlay, "%.2f ms (avg %.2f, max %.2f)", i.last(), i.average(), i.peak());
+
+			ImGui::PlotHistogram(
+				i.name.c_str(),
+				i.samples.data(), static_cast<int>(profiler::history), static_cast<int>(i.offset),
+				overlay, 0.f, FLT_MAX, { 260.f, 32.f }
+			);
+		}
+	}
+
+	void viewer::set_scroll_page_x(float amount, float factor) {
+		if (_page == nullptr)
+			return;
+
+		_scroll.position.x += amount * factor;
+
+		clamp_scroll();
+		update_view();
+	}
+
 	void viewer::set_scroll_page_y(float amount, float factor) {
 		if (_page == nullptr)
 			return;
 
-		sf::Vector2f size = _view.getSize();
-		float page_height = _page->get_header().size.y;
+		_scroll.position.y += amount * factor;
 
-		float step = amount * factor;
-		float max_step = -(page_height - size.y);
+		clamp_scroll();
+		update_view();
+	}
 
-		float after_step = _scroll.position.y + step;
+	void viewer::set_scroll_to(float y) {
+		// scroll positions are negative page offsets
+		set_scroll_page_y(-y - _scroll.position.y, 1.f);
+	}
 
-		if (amount > 0 && after_step > 0.f)
-			if (_scroll.position.y < 0.f)
-				step = -_scroll.position.y;
-			else
-				step = 0.f;
+	void viewer::reset_scroll() {
+		_scroll.position = { 0, 0 };
 
-		else if (after_step < max_step)
-			if (page_height > size.y)
-				step = max_step - _scroll.position.y - _drawing_offset.y;
-			else
-				step = 0.f;
+		// the overview is fitted to the page it was opened on
+		if (_overview) {
+			_overview = false;
+			_zoom = _overview_zoom;
+		}
 
-		_scroll.position.y += step;
+		update_view();
+	}
+
+	void viewer::clamp_scroll() {
+		if (_page == nullptr)
+			return;
+
+		sf::Vector2f size = sf::Vector2f(_window.getSize()) / _zoom;
+		const sf::Vector2i& page_size = _page->get_header().size;
+
+		// the viewport starts below the menu bar, so the bottom of the page needs that much more
+		float max_y = page_size.y - size.y + _drawing_offset.y / _zoom;
+		float max_x = page_size.x - size.x;
+
+		_scroll.position.y = max_y > 0.f ? -std::min(std::max(-_scroll.position.y, 0.f), max_y) : 0.f;
+		_scroll.position.x = max_x > 0.f ? std::min(std::max(_scroll.position.x, 0.f), max_x) : 0.f;
+	}
+
+	void viewer::update_view() {
+		sf::Vector2f size = sf::Vector2f(_window.getSize()) / _zoom;
 
 		_view.reset({
 			_scroll.position.x, -_scroll.position.y,
 			size.x, size.y
 		});
+	}
+
+	void viewer::set_zoom(float zoom, const sf::Vector2i& anchor) {
+		if (_page == nullptr)
+			return;
+
+		sf::Vector2f before = _window.mapPixelToCoords(anchor, _view);
 
-		_selector.move(0, step);
+		_zoom = std::min(std::max(zoom, min_zoom), max_zoom);
+		_overview = false;
+		update_view();
+
+		sf::Vector2f after = _window.mapPixelToCoords(anchor, _view);
+
+		_scroll.position.x -= after.x - before.x;
+		_scroll.position.y += after.y - before.y;
+
+		clamp_scroll();
+		update_view();
 	}
 
-	void viewer::reset_scroll() {
-		sf::Vector2f size = _view.getSize();
+	void viewer::toggle_overview() {
+		if (_page == nullptr)
+			return;
+
+		if (_overview) {
+			_overview = false;
+			_zoom = _overview_zoom;
+			_scroll = _overview_scroll;
+
+			clamp_scroll();
+			update_view();
+			return;
+		}
+
+		_overview_zoom = _zoom;
+		_overview_scroll = _scroll;
+
+		// the whole page below the menu bar, never enlarged
+		sf::Vector2f size(_window.getSize());
+		const sf::Vector2i& page_size = _page->get_header().size;
+
+		float fit = std::min(
+			size.x / std::max(page_size.x, 1),
+			(size.y - _drawing_offset.y) / std::max(page_size.y, 1)
+		);
+
+		_zoom = std::min(std::max(fit, min_zoom), 1.f);
 		_scroll.position = { 0, 0 };
+		_overview = true;
 
-		_view.reset({
-			_scroll.position.x, _scroll.position.y,
-			size.x, size.y
-		});
+		clamp_scroll();
+		update_view();
+	}
+
+	void viewer::leave_overview(const sf::Vector2f& center) {
+		_overview = false;
+		_zoom = _overview_zoom;
+
+		sf::Vector2f size = sf::Vector2f(_window.getSize()) / _zoom;
+		_scroll.position = { center.x - size.x / 2.f, -(center.y - size.y / 2.f) };
+
+		clamp_scroll();
+		update_view();
 	}
 
 #ifdef _WIN32
@@ -437,10 +842,6 @@ namespace obml_renderer {
 		this->region = region;
 	}
 
-	void selector::move(float x, float y) {
-		rect.move(x, y);
-	}
-
 	void selector::hide() {
 		has_show = false;
 		region = nullptr;
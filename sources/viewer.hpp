@@ -22,8 +22,7 @@ namespace obml_renderer {
 
 	public:
 		selector();
-		void show(const sf::Vector2f& position, const sf::Vector2f& size, link* region = nullptr);
-		void move(float x, float y);
+		void show(const sf::Vector2f& position, const sf::Vector2f& size, link* region = nullptr); // in page coordinates
 		void hide();
 		link* get_region();
 	};
@@ -46,20 +45,60 @@ namespace obml_renderer {
 		sf::View _view;
 
 		sptr_t<render::fonts> _fonts;
+		charsets _charsets;
+		uint64_t _fonts_key = 0;
+		std::future<void> _warmup;
+
 		scroll_info _scroll;
 		selector _selector;
 
+		float _zoom = 1.f; // window pixels per page pixel
+
+		// the whole page fitted into the window; zoom and scroll to go back to
+		bool _overview = false;
+		float _overview_zoom = 1.f;
+		scroll_info _overview_scroll;
+
 		sf::Vector2f _drawing_offset = { 0.f, 0.f };
 
+		profiler _frame_profiler;
+		profiler _load_profiler;
+
+		text_search _search;
+		std::future<void> _search_index;
+		char _search_query[128] = {};
+		size_t _search_current = 0;
+
 		bool show_page_info = false;
+		bool show_profiler = false;
+		bool merge_tiles = false;
 
 		void setup_imgui();
+		void setup_fonts();
+		void wait_fonts();
 		void draw_main_bar();
 		void draw_info();
+		void draw_profiler();
+		void draw_stages(const profiler& p);
 		void draw_tabs();
+		void draw_search();
+
+		void index_search();
+		void wait_search();
+		bool is_search_ready();
+		void jump_to_hit(size_t i);
 
+		void set_scroll_page_x(float amount, float factor = 64.f);
 		void set_scroll_page_y(float amount, float factor = 64.f);
+		void set_scroll_to(float y);
 		void reset_scroll();
+		void clamp_scroll();
+		void update_view();
+
+		// keeps the page point under anchor (window pixels) where it is
+		void set_zoom(float zoom, const sf::Vector2i& anchor);
+		void toggle_overview();
+		void leave_overview(const sf::Vector2f& center);
 
 #ifdef _WIN32
 		OPENFILENAME _ofn;
@@ -0,0 +1,76 @@
+#include "main.hpp"
+
+namespace obml_renderer {
+	writer::writer() {
+	}
+
+	void writer::write_byte(int8_t value) {
+		_data.push_back(static_cast<char>(value));
+	}
+
+	void writer::write_short(int16_t value) {
+		_data.push_back(static_cast<char>((value >> 8) & 0xFF));
+		_data.push_back(static_cast<char>(value & 0xFF));
+	}
+
+	void writer::write_medium(int32_t value) {
+		_data.push_back(static_cast<char>((value >> 16) & 0xFF));
+		_data.push_back(static_cast<char>((value >> 8) & 0xFF));
+		_data.push_back(static_cast<char>(value & 0xFF));
+	}
+
+	void writer::write_coord(const sf::Vector2i& value) {
+		write_short(static_cast<int16_t>(value.x));
+		write_medium(value.y);
+	}
+
+	void writer::write_color(const sf::Color& value) {
+		write_byte(value.a);
+		write_byte(value.r);
+		write_byte(value.g);
+		write_byte(value.b);
+	}
+
+	void writer::write_url(const std::string& value) {
+		write_string(value);
+	}
+
+	void writer::write_string(const std::string& value) {
+		write_blob(value.data(), value.size());
+	}
+
+	void writer::write_blob(const char* data, size_t len) {
+		write_short(static_cast<int16_t>(len));
+		_data.insert(_data.end(), data, data + len);
+	}
+
+	void writer::write_blob_alt(const char* data, size_t len) {
+		write_medium(static_cast<int32_t>(len));
+		_data.insert(_data.end(), data, data + len);
+	}
+
+	void writer::write_zero(size_t bytes) {
+		_data.resize(_data.size() + bytes, 0);
+	}
+
+	void writer::patch_medium(size_t pos, int32_t value) {
+		_data[pos] = static_cast<char>((value >> 16) & 0xFF);
+		_data[pos + 1] = static_cast<char>((value >> 8) & 0xFF);
+		_data[pos + 2] = static_cast<char>(value & 0xFF);
+	}
+
+	size_t writer::tell() const {
+		return _data.size();
+	}
+
+	const blob& writer::get_data() const {
+		return _data;
+	}
+
+	bool writer::save(const path& _path) const {
+		std::ofstream out(_path, std::ios::out | std::ios::trunc | std::ios::binary);
+		out.write(_data.data(), _data.size());
+
+		return out.good();
+	}
+};
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "main.hpp"
+
+namespace obml_renderer {
+	// mirror of reader: encodes OBML primitives into a memory buffer
+	class writer {
+	public:
+		writer();
+
+		void write_byte(int8_t value);
+		void write_short(int16_t value);
+		void write_medium(int32_t value);
+
+		void write_coord(const sf::Vector2i& value);
+		void write_color(const sf::Color& value);
+
+		void write_url(const std::string& value);
+		void write_string(const std::string& value);
+
+		void write_blob(const char* data, size_t len);
+		void write_blob_alt(const char* data, size_t len);
+		void write_zero(size_t bytes);
+
+		void patch_medium(size_t pos, int32_t value);
+
+		size_t tell() const;
+
+		const blob& get_data() const;
+		bool save(const path& _path) const;
+
+	private:
+		blob _data;
+	};
+};
\ No newline at end of file